@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "OS_Error.h"
+#include "OS_Dataport.h"
+
+#include <camkes.h>
+
+#include <stdint.h>
+#include <string.h>
+
+typedef enum
+{
+    /// Pass every call through to the storage below, this is the default
+    BlockCache_Mode_BYPASS = 0,
+    /// Serve from the cache, write dirty blocks only on eviction or flush
+    BlockCache_Mode_WRITE_BACK,
+} BlockCache_Mode_t;
+
+typedef struct
+{
+    uint64_t reads;         ///< read calls of the client
+    uint64_t writes;        ///< write calls of the client
+    uint64_t erases;        ///< erase calls of the client
+    uint64_t hits;          ///< blocks found in the cache
+    uint64_t misses;        ///< blocks not found in the cache
+    uint64_t lowerReads;    ///< read calls to the storage below
+    uint64_t lowerWrites;   ///< write calls to the storage below
+    uint64_t lowerErases;   ///< erase calls to the storage below
+    uint64_t writeBacks;    ///< dirty blocks written to the storage below
+} BlockCache_Stats_t;
+
+/**
+ * Get the statistics of the cache; they are passed through the storage
+ * dataport, so this must not be called while an I/O operation is in progress.
+ */
+static inline OS_Error_t
+BlockCache_getStats(
+    BlockCache_Stats_t* stats)
+{
+    const OS_Dataport_t port = OS_DATAPORT_ASSIGN(storage_port);
+    OS_Error_t err;
+    size_t sz;
+
+    if ((err = cache_rpc_getStats(&sz)) != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (sz != sizeof(*stats))
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    memcpy(stats, OS_Dataport_getBuf(port), sizeof(*stats));
+
+    return OS_SUCCESS;
+}
+
+#define CACHE_FLUSH         cache_rpc_flush()
+#define CACHE_STATS_RESET   cache_rpc_resetStats()
@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "block_cache.h"
+
+#include "OS_Dataport.h"
+#include "if_OS_Storage.h"
+
+#include "lib_debug/Debug.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <camkes.h>
+
+#define BLOCK_SIZE  CAMKES_CONST_ATTR(cache_block_size)
+#define BLOCKS      CAMKES_CONST_ATTR(cache_blocks)
+#define NIL         UINT32_MAX
+
+// Power of two with at least twice as many buckets as blocks
+#define HASH_BUCKETS    (1u << 16)
+#define HASH(_blk_)     ((uint32_t)((_blk_) * 2654435761u) % HASH_BUCKETS)
+
+typedef struct
+{
+    uint64_t block;     ///< block number, only valid if used
+    bool     used;
+    bool     dirty;
+    uint32_t prev;      ///< towards most recently used
+    uint32_t next;      ///< towards least recently used
+    uint32_t hashNext;
+} Entry_t;
+
+static Entry_t  entries[BLOCKS];
+static uint8_t  data[BLOCKS][BLOCK_SIZE];
+static uint32_t buckets[HASH_BUCKETS];
+static uint32_t mru, lru;
+
+static BlockCache_Stats_t stats;
+static off_t lowerSize = -1;
+
+static const if_OS_Storage_t lower =
+    IF_OS_STORAGE_ASSIGN(
+        lower_rpc,
+        lower_port);
+
+// Private Functions -----------------------------------------------------------
+
+static
+size_t
+getLowerBlocks(
+    void)
+{
+    // How many blocks we can move with one call to the storage below
+    return OS_Dataport_getSize(lower.dataport) / BLOCK_SIZE;
+}
+
+static
+bool
+isValidArea(
+    off_t const offset,
+    off_t const size)
+{
+    uintmax_t const end = (uintmax_t)offset + (uintmax_t)size;
+
+    // The storage below may not be ready during post_init(), so we ask for
+    // its size on first use
+    if ((lowerSize < 0) && (lower.getSize(&lowerSize) != OS_SUCCESS))
+    {
+        lowerSize = -1;
+        return false;
+    }
+
+    return ((offset >= 0)
+            && (size >= 0)
+            && (end >= offset)
+            && (end <= lowerSize)
+            && ((lowerSize % BLOCK_SIZE) == 0));
+}
+
+static
+void
+lruRemove(
+    uint32_t const idx)
+{
+    Entry_t* const e = &entries[idx];
+
+    if (e->prev != NIL)
+    {
+        entries[e->prev].next = e->next;
+    }
+    else
+    {
+        mru = e->next;
+    }
+    if (e->next != NIL)
+    {
+        entries[e->next].prev = e->prev;
+    }
+    else
+    {
+        lru = e->prev;
+    }
+}
+
+static
+void
+lruTouch(
+    uint32_t const idx)
+{
+    Entry_t* const e = &entries[idx];
+
+    if (mru == idx)
+    {
+        return;
+    }
+
+    lruRemove(idx);
+    e->prev = NIL;
+    e->next = mru;
+    entries[mru].prev = idx;
+    mru = idx;
+}
+
+static
+uint32_t
+lookup(
+    uint64_t const block)
+{
+    for (uint32_t idx = buckets[HASH(block)]; idx != NIL;
+         idx = entries[idx].hashNext)
+    {
+        if (entries[idx].block == block)
+        {
+            return idx;
+        }
+    }
+
+    return NIL;
+}
+
+static
+void
+unhash(
+    uint32_t const idx)
+{
+    uint32_t* p = &buckets[HASH(entries[idx].block)];
+
+    while (*p != idx)
+    {
+        Debug_ASSERT(*p != NIL);
+        p = &entries[*p].hashNext;
+    }
+    *p = entries[idx].hashNext;
+}
+
+static
+void
+drop(
+    uint32_t const idx)
+{
+    if (entries[idx].used)
+    {
+        unhash(idx);
+        entries[idx].used  = false;
+        entries[idx].dirty = false;
+    }
+}
+
+static
+OS_Error_t
+writeBack(
+    uint32_t const idx)
+{
+    Entry_t* const e = &entries[idx];
+    size_t written;
+    OS_Error_t err;
+
+    memcpy(OS_Dataport_getBuf(lower.dataport), data[idx], BLOCK_SIZE);
+
+    stats.lowerWrites++;
+    if ((err = lower.write(e->block * BLOCK_SIZE, BLOCK_SIZE,
+                           &written)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    stats.writeBacks++;
+    e->dirty = false;
+
+    return OS_SUCCESS;
+}
+
+/*
+ * Get an entry for a block which is not in the cache, evicting the least
+ * recently used one; its content is undefined.
+ */
+static
+OS_Error_t
+allocate(
+    uint64_t  const block,
+    uint32_t* const idx)
+{
+    uint32_t const victim = lru;
+    OS_Error_t err;
+
+    if (entries[victim].used && entries[victim].dirty)
+    {
+        if ((err = writeBack(victim)) != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+    drop(victim);
+
+    entries[victim].block    = block;
+    entries[victim].used     = true;
+    entries[victim].hashNext = buckets[HASH(block)];
+    buckets[HASH(block)]     = victim;
+    lruTouch(victim);
+
+    *idx = victim;
+
+    return OS_SUCCESS;
+}
+
+/*
+ * Fetch count consecutive blocks starting at block from the storage below
+ * with a single call.
+ */
+static
+OS_Error_t
+fetch(
+    uint64_t  const block,
+    size_t    const count,
+    uint32_t* const idx)
+{
+    const uint8_t* const buf = OS_Dataport_getBuf(lower.dataport);
+    size_t read;
+    OS_Error_t err;
+
+    // Allocate first, an eviction may need the dataport for writing back
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((err = allocate(block + i, &idx[i])) != OS_SUCCESS)
+        {
+            while (i-- > 0)
+            {
+                drop(idx[i]);
+            }
+            return err;
+        }
+    }
+
+    stats.lowerReads++;
+    if ((err = lower.read(block * BLOCK_SIZE, count * BLOCK_SIZE,
+                          &read)) != OS_SUCCESS)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            drop(idx[i]);
+        }
+        return err;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(data[idx[i]], &buf[i * BLOCK_SIZE], BLOCK_SIZE);
+    }
+
+    return OS_SUCCESS;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+Cache_init(
+    void)
+{
+    for (uint32_t i = 0; i < HASH_BUCKETS; i++)
+    {
+        buckets[i] = NIL;
+    }
+    for (uint32_t i = 0; i < BLOCKS; i++)
+    {
+        entries[i].used  = false;
+        entries[i].dirty = false;
+        entries[i].prev  = (i > 0) ? i - 1 : NIL;
+        entries[i].next  = (i < (BLOCKS - 1)) ? i + 1 : NIL;
+    }
+    mru = 0;
+    lru = BLOCKS - 1;
+
+    Debug_ASSERT(BLOCKS <= (HASH_BUCKETS / 2));
+    Debug_ASSERT(getLowerBlocks() > 0);
+
+    Debug_LOG_INFO("Cache of %u blocks with %u bytes", BLOCKS, BLOCK_SIZE);
+}
+
+OS_Error_t
+Cache_read(
+    off_t   const offset,
+    void*   const buf,
+    size_t  const size,
+    size_t* const read)
+{
+    static uint32_t run[BLOCKS];
+    uint8_t* dst = buf;
+    uint64_t pos = offset;
+    size_t left  = size;
+    // Never fetch so many blocks that we would evict what we just fetched
+    size_t const maxRun = (getLowerBlocks() < (BLOCKS / 2)) ?
+                          getLowerBlocks() : (BLOCKS / 2);
+    size_t ahead = 0;
+    OS_Error_t err;
+
+    *read = 0;
+
+    if (!isValidArea(offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    while (left > 0)
+    {
+        uint64_t const block = pos / BLOCK_SIZE;
+        size_t const inBlock = pos % BLOCK_SIZE;
+        size_t const len = (left < (BLOCK_SIZE - inBlock)) ?
+                           left : (BLOCK_SIZE - inBlock);
+        uint32_t idx = lookup(block);
+
+        if (idx != NIL)
+        {
+            // Blocks we fetched along with a miss were counted already
+            if (ahead > 0)
+            {
+                ahead--;
+            }
+            else
+            {
+                stats.hits++;
+            }
+            lruTouch(idx);
+        }
+        else
+        {
+            // Fetch this block and the following ones we will need as well,
+            // as long as they are missing too
+            size_t const need = (inBlock + left + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            size_t count = 1;
+
+            while ((count < need) && (count < maxRun)
+                   && (lookup(block + count) == NIL))
+            {
+                count++;
+            }
+
+            stats.misses += count;
+            if ((err = fetch(block, count, run)) != OS_SUCCESS)
+            {
+                return err;
+            }
+            idx   = run[0];
+            ahead = count - 1;
+        }
+
+        memcpy(dst, &data[idx][inBlock], len);
+
+        pos   += len;
+        dst   += len;
+        left  -= len;
+        *read += len;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+Cache_write(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size,
+    size_t*     const written)
+{
+    const uint8_t* src = buf;
+    uint64_t pos = offset;
+    size_t left  = size;
+    OS_Error_t err;
+
+    *written = 0;
+
+    if (!isValidArea(offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    while (left > 0)
+    {
+        uint64_t const block = pos / BLOCK_SIZE;
+        size_t const inBlock = pos % BLOCK_SIZE;
+        size_t const len = (left < (BLOCK_SIZE - inBlock)) ?
+                           left : (BLOCK_SIZE - inBlock);
+        uint32_t idx = lookup(block);
+
+        if (idx != NIL)
+        {
+            stats.hits++;
+            lruTouch(idx);
+        }
+        else
+        {
+            stats.misses++;
+            // A block which is overwritten completely need not be read first
+            err = (len == BLOCK_SIZE) ?
+                  allocate(block, &idx) : fetch(block, 1, &idx);
+            if (err != OS_SUCCESS)
+            {
+                return err;
+            }
+        }
+
+        memcpy(&data[idx][inBlock], src, len);
+        entries[idx].dirty = true;
+
+        pos      += len;
+        src      += len;
+        left     -= len;
+        *written += len;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+Cache_erase(
+    off_t  const offset,
+    off_t  const size,
+    off_t* const erased)
+{
+    uint64_t const end = (uint64_t)offset + size;
+    OS_Error_t err;
+
+    *erased = 0;
+
+    stats.lowerErases++;
+    if ((err = lower.erase(offset, size, erased)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // Keep the cached blocks consistent with what is now on the storage
+    for (uint32_t idx = 0; idx < BLOCKS; idx++)
+    {
+        uint64_t const start = entries[idx].block * BLOCK_SIZE;
+        uint64_t from, to;
+
+        if (!entries[idx].used
+            || (start >= end) || ((start + BLOCK_SIZE) <= (uint64_t)offset))
+        {
+            continue;
+        }
+
+        from = ((uint64_t)offset > start) ? (uint64_t)offset : start;
+        to   = (end < (start + BLOCK_SIZE)) ? end : (start + BLOCK_SIZE);
+        memset(&data[idx][from - start], 0xFF, to - from);
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+Cache_flush(
+    void)
+{
+    static uint32_t dirty[BLOCKS];
+    uint8_t* const buf = OS_Dataport_getBuf(lower.dataport);
+    size_t const maxRun = getLowerBlocks();
+    size_t count = 0, written;
+    OS_Error_t err;
+
+    for (uint32_t idx = 0; idx < BLOCKS; idx++)
+    {
+        if (entries[idx].used && entries[idx].dirty)
+        {
+            // Keep the list sorted by block number (insertion sort is good
+            // enough for the few hundred blocks we have)
+            size_t i = count++;
+            while ((i > 0) && (entries[dirty[i - 1]].block >
+                               entries[idx].block))
+            {
+                dirty[i] = dirty[i - 1];
+                i--;
+            }
+            dirty[i] = idx;
+        }
+    }
+
+    for (size_t i = 0; i < count; )
+    {
+        uint64_t const block = entries[dirty[i]].block;
+        size_t run = 0;
+
+        // Write back adjacent dirty blocks with one call
+        while (((i + run) < count) && (run < maxRun)
+               && (entries[dirty[i + run]].block == (block + run)))
+        {
+            memcpy(&buf[run * BLOCK_SIZE], data[dirty[i + run]], BLOCK_SIZE);
+            run++;
+        }
+
+        stats.lowerWrites++;
+        if ((err = lower.write(block * BLOCK_SIZE, run * BLOCK_SIZE,
+                               &written)) != OS_SUCCESS)
+        {
+            return err;
+        }
+
+        for (size_t j = 0; j < run; j++)
+        {
+            entries[dirty[i + j]].dirty = false;
+        }
+        stats.writeBacks += run;
+        i += run;
+    }
+
+    return OS_SUCCESS;
+}
+
+void
+Cache_invalidate(
+    void)
+{
+    for (uint32_t idx = 0; idx < BLOCKS; idx++)
+    {
+        Debug_ASSERT(!entries[idx].dirty);
+        drop(idx);
+    }
+}
+
+BlockCache_Stats_t*
+Cache_getStats(
+    void)
+{
+    return &stats;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "OS_Error.h"
+#include "BlockCache.h"
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * LRU cache of fixed size blocks of the storage below, with write-back: dirty
+ * blocks are only written when they are evicted or the cache is flushed. Runs
+ * of blocks missing on read are fetched with one call, adjacent dirty blocks
+ * are written back with one call on flush.
+ *
+ * Erase is always passed through and applied to the cached blocks as well;
+ * the cache is meant for media which can be overwritten.
+ */
+
+void
+Cache_init(
+    void);
+
+OS_Error_t
+Cache_read(
+    off_t   const offset,
+    void*   const buf,
+    size_t  const size,
+    size_t* const read);
+
+OS_Error_t
+Cache_write(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size,
+    size_t*     const written);
+
+OS_Error_t
+Cache_erase(
+    off_t  const offset,
+    off_t  const size,
+    off_t* const erased);
+
+/**
+ * Write all dirty blocks to the storage below.
+ */
+OS_Error_t
+Cache_flush(
+    void);
+
+/**
+ * Drop all blocks; dirty blocks must have been flushed before.
+ */
+void
+Cache_invalidate(
+    void);
+
+BlockCache_Stats_t*
+Cache_getStats(
+    void);
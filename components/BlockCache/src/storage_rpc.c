@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "OS_Error.h"
+#include "OS_Dataport.h"
+#include "if_OS_Storage.h"
+#include "BlockCache.h"
+
+#include "block_cache.h"
+
+#include "lib_debug/Debug.h"
+
+#include <string.h>
+#include <camkes.h>
+
+static const OS_Dataport_t port = OS_DATAPORT_ASSIGN(storage_port);
+
+static const if_OS_Storage_t lower =
+    IF_OS_STORAGE_ASSIGN(
+        lower_rpc,
+        lower_port);
+
+static BlockCache_Mode_t mode = BlockCache_Mode_BYPASS;
+
+// Private Functions -----------------------------------------------------------
+
+/*
+ * In bypass mode the data is copied between the two dataports and the call is
+ * passed on, so the storage below sees exactly what the client does.
+ */
+static
+OS_Error_t
+bypassWrite(
+    off_t   const offset,
+    size_t  const size,
+    size_t* const written)
+{
+    if (size > OS_Dataport_getSize(lower.dataport))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    memcpy(OS_Dataport_getBuf(lower.dataport), OS_Dataport_getBuf(port), size);
+    Cache_getStats()->lowerWrites++;
+
+    return lower.write(offset, size, written);
+}
+
+static
+OS_Error_t
+bypassRead(
+    off_t   const offset,
+    size_t  const size,
+    size_t* const read)
+{
+    OS_Error_t err;
+
+    if (size > OS_Dataport_getSize(lower.dataport))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    Cache_getStats()->lowerReads++;
+    if ((err = lower.read(offset, size, read)) == OS_SUCCESS)
+    {
+        memcpy(OS_Dataport_getBuf(port), OS_Dataport_getBuf(lower.dataport),
+               *read);
+    }
+
+    return err;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+post_init(
+    void)
+{
+    Cache_init();
+}
+
+OS_Error_t
+NONNULL_ALL
+storage_rpc_write(
+    off_t   const offset,
+    size_t  const size,
+    size_t* const written)
+{
+    OS_Error_t err;
+
+    *written = 0U;
+
+    if (size > OS_Dataport_getSize(port))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    cache_lock_lock();
+    Cache_getStats()->writes++;
+    err = (mode == BlockCache_Mode_BYPASS) ?
+          bypassWrite(offset, size, written) :
+          Cache_write(offset, OS_Dataport_getBuf(port), size, written);
+    cache_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+NONNULL_ALL
+storage_rpc_read(
+    off_t   const offset,
+    size_t  const size,
+    size_t* const read)
+{
+    OS_Error_t err;
+
+    *read = 0U;
+
+    if (size > OS_Dataport_getSize(port))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    cache_lock_lock();
+    Cache_getStats()->reads++;
+    err = (mode == BlockCache_Mode_BYPASS) ?
+          bypassRead(offset, size, read) :
+          Cache_read(offset, OS_Dataport_getBuf(port), size, read);
+    cache_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+NONNULL_ALL
+storage_rpc_erase(
+    off_t  const offset,
+    off_t  const size,
+    off_t* const erased)
+{
+    OS_Error_t err;
+
+    cache_lock_lock();
+    Cache_getStats()->erases++;
+    if (mode == BlockCache_Mode_BYPASS)
+    {
+        Cache_getStats()->lowerErases++;
+        err = lower.erase(offset, size, erased);
+    }
+    else
+    {
+        err = Cache_erase(offset, size, erased);
+    }
+    cache_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+NONNULL_ALL
+storage_rpc_getSize(
+    off_t* const size)
+{
+    return lower.getSize(size);
+}
+
+OS_Error_t
+NONNULL_ALL
+storage_rpc_getBlockSize(
+    size_t* const blockSize)
+{
+    return lower.getBlockSize(blockSize);
+}
+
+OS_Error_t
+NONNULL_ALL
+storage_rpc_getState(
+    uint32_t* flags)
+{
+    return lower.getState(flags);
+}
+
+OS_Error_t
+cache_rpc_setMode(
+    int newMode)
+{
+    OS_Error_t err = OS_SUCCESS;
+
+    if ((newMode != BlockCache_Mode_BYPASS)
+        && (newMode != BlockCache_Mode_WRITE_BACK))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    cache_lock_lock();
+    if ((mode == BlockCache_Mode_WRITE_BACK) && (newMode != mode))
+    {
+        // Nothing may stay behind in the cache once calls are passed through
+        if ((err = Cache_flush()) == OS_SUCCESS)
+        {
+            Cache_invalidate();
+        }
+    }
+    if (err == OS_SUCCESS)
+    {
+        mode = newMode;
+    }
+    cache_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+cache_rpc_flush(
+    void)
+{
+    OS_Error_t err;
+
+    cache_lock_lock();
+    err = Cache_flush();
+    cache_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+NONNULL_ALL
+cache_rpc_getStats(
+    size_t* const size)
+{
+    *size = 0;
+
+    if (sizeof(BlockCache_Stats_t) > OS_Dataport_getSize(port))
+    {
+        Debug_LOG_ERROR("Stats (%zu bytes) exceed dataport size",
+                        sizeof(BlockCache_Stats_t));
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    cache_lock_lock();
+    memcpy(OS_Dataport_getBuf(port), Cache_getStats(),
+           sizeof(BlockCache_Stats_t));
+    cache_lock_unlock();
+    *size = sizeof(BlockCache_Stats_t);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+cache_rpc_resetStats(
+    void)
+{
+    cache_lock_lock();
+    memset(Cache_getStats(), 0, sizeof(BlockCache_Stats_t));
+    cache_lock_unlock();
+
+    return OS_SUCCESS;
+}
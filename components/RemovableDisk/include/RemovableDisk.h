@@ -9,8 +9,14 @@
 
 #pragma once
 
+#include "OS_Error.h"
+#include "OS_Dataport.h"
+
 #include <camkes.h>
 
+#include <stdint.h>
+#include <string.h>
+
 /**
  * Use additional RPC endpoint to switch on "storage removal"; the param we use
  * here means:
@@ -18,4 +24,188 @@
  * -1: do not pretend medium was removed
  */
 #define DISK_REMOVE disk_rpc_triggerRemoval( 0)
-#define DISK_ATTACH disk_rpc_triggerRemoval(-1)
\ No newline at end of file
+#define DISK_ATTACH disk_rpc_triggerRemoval(-1)
+
+/**
+ * Cut the power in the middle of the write (or erase) which follows the next
+ * _mods_ ones, so it is torn after _cut_ bytes (after a random number of bytes
+ * if _cut_ < 0). The medium then keeps its content but fails all operations
+ * as if removed, until the power is back on.
+ */
+#define DISK_POWER_CUT(_mods_, _cut_)   disk_rpc_powerCut(_mods_, _cut_)
+#define DISK_POWER_ON                   disk_rpc_powerCut(-1, 0)
+
+/**
+ * Number of partitions (storage interfaces covering a window of the medium)
+ * a disk can serve besides the storage interface covering all of it.
+ */
+#define RemovableDisk_MAX_PARTITIONS 4
+
+/**
+ * Storage operations for which the disk keeps statistics.
+ */
+typedef enum
+{
+    RemovableDisk_Op_READ = 0,
+    RemovableDisk_Op_WRITE,
+    RemovableDisk_Op_ERASE,
+    RemovableDisk_Op_GET_SIZE,
+
+    RemovableDisk_Op_NUM
+} RemovableDisk_Op_t;
+
+/**
+ * Number of buckets in the latency histogram; bucket i counts the operations
+ * which took [2^i, 2^(i+1)) ns, the last bucket also gets everything above.
+ */
+#define RemovableDisk_STATS_BUCKETS 32
+
+typedef struct
+{
+    uint64_t calls;     ///< number of calls, including failed ones
+    uint64_t errors;    ///< number of calls which returned an error
+    uint64_t bytes;     ///< number of bytes read/written/erased
+    uint64_t ns;        ///< accumulated time spent in the disk
+    uint32_t latency[RemovableDisk_STATS_BUCKETS];
+} RemovableDisk_OpStats_t;
+
+typedef struct
+{
+    RemovableDisk_OpStats_t ops[RemovableDisk_Op_NUM];
+    uint64_t allocated; ///< bytes of memory currently holding the medium
+} RemovableDisk_Stats_t;
+
+/**
+ * Get the I/O statistics of the disk; they are passed through the disk
+ * dataport (which is separate from the storage dataport, as the storage
+ * interface may be connected through another component).
+ */
+static inline OS_Error_t
+RemovableDisk_getStats(
+    RemovableDisk_Stats_t* stats)
+{
+    const OS_Dataport_t port = OS_DATAPORT_ASSIGN(disk_port);
+    OS_Error_t err;
+    size_t sz;
+
+    if ((err = disk_rpc_getStats(&sz)) != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (sz != sizeof(*stats))
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    memcpy(stats, OS_Dataport_getBuf(port), sizeof(*stats));
+
+    return OS_SUCCESS;
+}
+
+#define DISK_STATS_RESET disk_rpc_resetStats()
+
+/**
+ * Vectored I/O moves several extents with one RPC. The disk dataport then
+ * starts with an array of extents, the data of all extents follows right after
+ * it, packed in the same order.
+ */
+typedef struct
+{
+    off_t  offset;
+    size_t size;
+} RemovableDisk_Extent_t;
+
+#define RemovableDisk_MAX_EXTENTS 64
+
+#define RemovableDisk_EXTENTS_DATA(_buf_, _count_) \
+    ((uint8_t*)(_buf_) + ((_count_) * sizeof(RemovableDisk_Extent_t)))
+
+
+/**
+ * Asynchronous I/O: the client puts requests into the submission ring and
+ * signals the disk, the disk puts the results into the completion ring and
+ * signals the client. Both rings live in the async dataport; the data of each
+ * request lives in its own slot of the async data dataport, so up to
+ * RemovableDisk_ASYNC_DEPTH requests can be in flight.
+ *
+ * The ring indices are free running, an entry is at (index % depth). Only the
+ * client writes sqTail and cqHead, only the disk writes sqHead and cqTail.
+ */
+#define RemovableDisk_ASYNC_DEPTH       8
+#define RemovableDisk_ASYNC_SLOT_SIZE   4096
+// Size of the async data dataport, it is bigger than a default dataport
+#define RemovableDisk_ASYNC_DATA_SIZE   \
+    (RemovableDisk_ASYNC_DEPTH * RemovableDisk_ASYNC_SLOT_SIZE)
+
+typedef struct
+{
+    uint64_t tag;       ///< opaque value, returned in the completion
+    uint32_t op;        ///< RemovableDisk_Op_READ, _WRITE or _ERASE
+    uint32_t slot;      ///< data slot to read from or write into, unused
+                        ///< by an erase, which may be of any size
+    off_t    offset;
+    size_t   size;
+} RemovableDisk_AsyncRequest_t;
+
+typedef struct
+{
+    uint64_t   tag;
+    OS_Error_t err;
+    size_t     size;    ///< bytes read, written or erased
+} RemovableDisk_AsyncCompletion_t;
+
+typedef struct
+{
+    uint32_t sqHead;
+    uint32_t sqTail;
+    uint32_t cqHead;
+    uint32_t cqTail;
+    RemovableDisk_AsyncRequest_t    sq[RemovableDisk_ASYNC_DEPTH];
+    RemovableDisk_AsyncCompletion_t cq[RemovableDisk_ASYNC_DEPTH];
+} RemovableDisk_AsyncRings_t;
+
+#define RemovableDisk_ASYNC_SLOT(_buf_, _slot_) \
+    ((uint8_t*)(_buf_) + ((_slot_) * RemovableDisk_ASYNC_SLOT_SIZE))
+
+
+/**
+ * Trace of the storage operations the disk has seen: while capturing, each
+ * operation (each extent for vectored I/O) becomes an entry. The entries are
+ * read out through the disk dataport in chunks, and can be handed back to the
+ * disk in chunks to be replayed.
+ */
+typedef struct
+{
+    uint64_t ns;        ///< time issued, relative to the first entry
+    off_t    offset;
+    uint64_t size;
+    uint32_t op;        ///< RemovableDisk_Op_t
+} RemovableDisk_TraceEntry_t;
+
+/// Largest read or write which can be replayed
+#define RemovableDisk_TRACE_MAX_SIZE    32768
+/// Most entries which can be replayed with one call
+#define RemovableDisk_MAX_TRACE_CHUNK   1024
+
+#define DISK_TRACE_START    disk_rpc_setTrace(1)
+#define DISK_TRACE_STOP     disk_rpc_setTrace(0)
+
+
+/**
+ * Modifications of the medium: the generation increments with every write or
+ * erase which succeeded and never goes back, so comparing two values tells if
+ * anything was modified in between. The bitmap has a bit set for every block
+ * which was modified since it was last reset.
+ */
+typedef struct
+{
+    uint64_t generation;
+    uint32_t blockSize;     ///< bytes covered by one bit
+    uint32_t blocks;        ///< number of bits in the bitmap
+    uint8_t  bitmap[];      ///< bit (i % 8) of byte (i / 8) is block i
+} RemovableDisk_DirtyMap_t;
+
+#define RemovableDisk_IS_DIRTY(_map_, _blk_) \
+    (((_map_)->bitmap[(_blk_) / 8] >> ((_blk_) % 8)) & 1)
+
+#define DISK_DIRTY_RESET disk_rpc_resetDirty()
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_async.h"
+#include "disk_io.h"
+
+#include "OS_Dataport.h"
+#include "RemovableDisk.h"
+
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+static const OS_Dataport_t ringPort = OS_DATAPORT_ASSIGN(async_port);
+static const OS_Dataport_t dataPort =
+    OS_DATAPORT_ASSIGN_SIZE(async_data_port, RemovableDisk_ASYNC_DATA_SIZE);
+
+// Private Functions -----------------------------------------------------------
+
+static
+OS_Error_t
+process(
+    const RemovableDisk_AsyncRequest_t* const req,
+    size_t*                             const done)
+{
+    void* buf;
+    off_t erased;
+    OS_Error_t err;
+
+    *done = 0;
+
+    switch (req->op)
+    {
+    case RemovableDisk_Op_WRITE:
+    case RemovableDisk_Op_READ:
+        // Only these have data, which must fit into their slot
+        if ((req->slot >= RemovableDisk_ASYNC_DEPTH)
+            || (req->size > RemovableDisk_ASYNC_SLOT_SIZE))
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        buf = RemovableDisk_ASYNC_SLOT(OS_Dataport_getBuf(dataPort),
+                                       req->slot);
+        return (req->op == RemovableDisk_Op_WRITE) ?
+               DiskIo_write(req->offset, buf, req->size, done) :
+               DiskIo_read(req->offset, buf, req->size, done);
+    case RemovableDisk_Op_ERASE:
+        err = DiskIo_erase(req->offset, req->size, &erased);
+        *done = erased;
+        return err;
+    default:
+        break;
+    }
+
+    return OS_ERROR_INVALID_PARAMETER;
+}
+
+static
+void
+onSubmit(
+    void* ctx)
+{
+    RemovableDisk_AsyncRings_t* const rings = OS_Dataport_getBuf(ringPort);
+    RemovableDisk_AsyncRequest_t req;
+    RemovableDisk_AsyncCompletion_t* cpl;
+    uint32_t head, tail, cqTail;
+
+    head = rings->sqHead;
+    tail = __atomic_load_n(&rings->sqTail, __ATOMIC_ACQUIRE);
+
+    while (head != tail)
+    {
+        // Take a copy, the client may (wrongly) change the entry meanwhile
+        req = rings->sq[head % RemovableDisk_ASYNC_DEPTH];
+        __atomic_store_n(&rings->sqHead, ++head, __ATOMIC_RELEASE);
+
+        /*
+         * The client never has more requests in flight than there are slots,
+         * so there is always room in the completion ring.
+         */
+        cqTail = rings->cqTail;
+        cpl = &rings->cq[cqTail % RemovableDisk_ASYNC_DEPTH];
+        cpl->tag = req.tag;
+        cpl->err = process(&req, &cpl->size);
+        __atomic_store_n(&rings->cqTail, cqTail + 1, __ATOMIC_RELEASE);
+
+        // Signal every completion so the client can reuse the slot right away
+        async_complete_emit();
+
+        tail = __atomic_load_n(&rings->sqTail, __ATOMIC_ACQUIRE);
+    }
+
+    // A submission which came in meanwhile leaves the notification pending,
+    // so we will be called again right away
+    if (async_submit_reg_callback(onSubmit, NULL) != 0)
+    {
+        Debug_LOG_ERROR("async_submit_reg_callback() failed");
+    }
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskAsync_init(
+    void)
+{
+    if ((sizeof(RemovableDisk_AsyncRings_t) > OS_Dataport_getSize(ringPort))
+        || ((RemovableDisk_ASYNC_DEPTH * RemovableDisk_ASYNC_SLOT_SIZE) >
+            OS_Dataport_getSize(dataPort)))
+    {
+        Debug_LOG_ERROR("Async dataports too small, async I/O disabled");
+        return;
+    }
+
+    if (async_submit_reg_callback(onSubmit, NULL) != 0)
+    {
+        Debug_LOG_ERROR("async_submit_reg_callback() failed");
+    }
+}
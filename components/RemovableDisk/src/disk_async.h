@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+/**
+ * Start serving the asynchronous submission ring, see
+ * RemovableDisk_AsyncRings_t.
+ */
+void
+DiskAsync_init(
+    void);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_dirty.h"
+
+#include "lib_debug/Debug.h"
+
+#include <string.h>
+#include <camkes.h>
+
+#define STORAGE_SIZE    CAMKES_CONST_ATTR(storage_size)
+#define BLOCK_SIZE      CAMKES_CONST_ATTR(dirty_block_size)
+#define BLOCKS          ((STORAGE_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE)
+
+static uint8_t bitmap[(BLOCKS + 7) / 8];
+static uint64_t generation;
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskDirty_init(
+    void)
+{
+    Debug_ASSERT(BLOCK_SIZE > 0);
+}
+
+void
+DiskDirty_mark(
+    off_t  const offset,
+    off_t  const size)
+{
+    generation++;
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    for (uint64_t blk = offset / BLOCK_SIZE;
+         blk <= (uint64_t)(offset + size - 1) / BLOCK_SIZE; blk++)
+    {
+        bitmap[blk / 8] |= (uint8_t)(1u << (blk % 8));
+    }
+}
+
+uint64_t
+DiskDirty_getGeneration(
+    void)
+{
+    return generation;
+}
+
+size_t
+DiskDirty_getMapSize(
+    void)
+{
+    return sizeof(RemovableDisk_DirtyMap_t) + sizeof(bitmap);
+}
+
+void
+DiskDirty_getMap(
+    RemovableDisk_DirtyMap_t* const dst)
+{
+    dst->generation = generation;
+    dst->blockSize  = BLOCK_SIZE;
+    dst->blocks     = BLOCKS;
+    memcpy(dst->bitmap, bitmap, sizeof(bitmap));
+}
+
+void
+DiskDirty_reset(
+    void)
+{
+    memset(bitmap, 0, sizeof(bitmap));
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "RemovableDisk.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Tracking of modifications: a generation counter which increments with every
+ * write or erase that succeeded, and a bitmap with one bit per block of
+ * dirty_block_size bytes that were modified since the bitmap was reset.
+ */
+
+void
+DiskDirty_init(
+    void);
+
+/**
+ * Account a successful modification of an area of the medium.
+ */
+void
+DiskDirty_mark(
+    off_t  const offset,
+    off_t  const size);
+
+uint64_t
+DiskDirty_getGeneration(
+    void);
+
+/**
+ * Get the size of the dirty map including the bitmap.
+ */
+size_t
+DiskDirty_getMapSize(
+    void);
+
+/**
+ * Copy the dirty map to dst, which must hold DiskDirty_getMapSize() bytes.
+ */
+void
+DiskDirty_getMap(
+    RemovableDisk_DirtyMap_t* const dst);
+
+/**
+ * Clear the bitmap; the generation keeps counting.
+ */
+void
+DiskDirty_reset(
+    void);
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_image.h"
+#include "disk_medium.h"
+
+#include "lib_debug/Debug.h"
+
+#include <stdint.h>
+
+#if defined(RemovableDisk_IMAGE_PATH)
+
+/*
+ * The assembler puts the file into the read-only data as it is, so no tool is
+ * needed to convert it and the build stays fast also for big images.
+ */
+__asm__(
+    "    .section .rodata\n"
+    "    .balign 8\n"
+    "    .global DiskImage_start\n"
+    "DiskImage_start:\n"
+    "    .incbin \"" RemovableDisk_IMAGE_PATH "\"\n"
+    "    .global DiskImage_end\n"
+    "DiskImage_end:\n"
+    "    .previous\n"
+);
+
+extern const uint8_t DiskImage_start[];
+extern const uint8_t DiskImage_end[];
+
+#endif
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskImage_load(
+    void)
+{
+#if defined(RemovableDisk_IMAGE_PATH)
+    size_t size = DiskImage_end - DiskImage_start;
+    OS_Error_t err;
+
+    if (size > DiskMedium_getSize())
+    {
+        Debug_LOG_WARNING("Image of %zu bytes does not fit, using the first "
+                          "%jd bytes", size, (intmax_t)DiskMedium_getSize());
+        size = DiskMedium_getSize();
+    }
+
+    // Like a raw copy to the device, so no flash rules apply
+    if ((err = DiskMedium_load(0, DiskImage_start, size)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Loading image failed, code %d", err);
+        return;
+    }
+
+    Debug_LOG_INFO("Loaded %zu bytes from image '%s'", size,
+                   RemovableDisk_IMAGE_PATH);
+#endif
+}
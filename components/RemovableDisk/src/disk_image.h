@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+/*
+ * An image file embedded at build time (see DISK_IMAGE in CMakeLists.txt),
+ * which becomes the initial content of the medium. Without one, the medium
+ * starts out empty.
+ */
+
+/**
+ * Put the image at the start of the medium; the medium must be initialized.
+ * An image bigger than the medium is cut off.
+ */
+void
+DiskImage_load(
+    void);
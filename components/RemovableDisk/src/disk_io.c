@@ -0,0 +1,685 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_io.h"
+#include "disk_dirty.h"
+#include "disk_image.h"
+#include "disk_medium.h"
+#include "disk_power.h"
+#include "disk_snapshot.h"
+#include "disk_stats.h"
+#include "disk_timer.h"
+#include "disk_timing.h"
+#include "disk_trace.h"
+
+#include "lib_debug/Debug.h"
+
+#include <string.h>
+#include <camkes.h>
+
+static int opsCountdown = -1;
+
+// Private Functions -----------------------------------------------------------
+
+static
+bool
+isMediumPresent(
+    void)
+{
+    /*
+     * This has three behaviors:
+     * 1. If opsCountdown == 0, medium is not present
+     * 2. If opsCountdown != 0, medium is present
+     * 2.1 Count down to 0 if opsCountdown > 0
+     * 2.2 Just leave the opsCountdown value if < 0; this allows to leave the
+     *     disk in a permanent "ready" mode.
+     *
+     * A medium frozen by a power cut is not present either, no matter what
+     * opsCountdown says.
+     */
+
+    if (DiskPower_isFrozen()) {
+        return false;
+    }
+    if (!opsCountdown) {
+        return false;
+    }
+    if (opsCountdown > 0) {
+        opsCountdown = opsCountdown - 1;
+    }
+    return true;
+}
+
+static
+OS_Error_t
+doWrite(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size,
+    size_t*     const written)
+{
+    *written = 0U;
+
+    if (!isMediumPresent()) {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    if (!DiskMedium_isValidArea(offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    size_t const len = DiskPower_getThrough(size, DiskMedium_getWriteSize());
+
+    // Keep what the snapshot needs before it gets overwritten
+    OS_Error_t err = DiskSnapshot_save(offset, size);
+    if (err == OS_SUCCESS)
+    {
+        err = DiskMedium_write(offset, buf, len);
+    }
+    if (err == OS_SUCCESS)
+    {
+        DiskDirty_mark(offset, len);
+    }
+    if ((err == OS_SUCCESS) && (len < size))
+    {
+        // The power failed halfway
+        err = OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    *written = (err == OS_SUCCESS) ? size : 0U;
+
+    return err;
+}
+
+static
+OS_Error_t
+doRead(
+    off_t   const offset,
+    void*   const buf,
+    size_t  const size,
+    size_t* const read)
+{
+    *read = 0U;
+
+    if (!isMediumPresent()) {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    if (!DiskMedium_isValidArea(offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    OS_Error_t const err = DiskMedium_read(offset, buf, size);
+    *read = (err == OS_SUCCESS) ? size : 0U;
+
+    return err;
+}
+
+static
+OS_Error_t
+doErase(
+    off_t  const offset,
+    off_t  const size,
+    off_t* const erased)
+{
+    *erased = 0;
+
+    if (!isMediumPresent()) {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    if (!DiskMedium_isValidArea(offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    off_t const len = (off_t)DiskPower_getThrough((size_t)size,
+                                                  DiskMedium_getBlockSize());
+
+    OS_Error_t err = DiskSnapshot_save(offset, size);
+    if (err == OS_SUCCESS)
+    {
+        err = DiskMedium_erase(offset, len);
+    }
+    if (err == OS_SUCCESS)
+    {
+        DiskDirty_mark(offset, len);
+    }
+    if ((err == OS_SUCCESS) && (len < size))
+    {
+        err = OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    *erased = (err == OS_SUCCESS) ? size : 0;
+
+    return err;
+}
+
+static
+OS_Error_t
+doWritev(
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    const uint8_t*                      data,
+    size_t*                       const written)
+{
+    size_t total = 0, left;
+    OS_Error_t err;
+
+    *written = 0U;
+
+    if (!isMediumPresent()) {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+
+    // A power cut tears the whole vector, so it may hit any of the extents
+    for (size_t i = 0; i < count; i++)
+    {
+        total += extents[i].size;
+    }
+    left = DiskPower_getThrough(total, DiskMedium_getWriteSize());
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t const len = (left < extents[i].size) ? left : extents[i].size;
+
+        if (((err = DiskSnapshot_save(extents[i].offset,
+                                      extents[i].size)) != OS_SUCCESS)
+            || ((err = DiskMedium_write(extents[i].offset, data,
+                                        len)) != OS_SUCCESS))
+        {
+            return err;
+        }
+        DiskDirty_mark(extents[i].offset, len);
+        if (len < extents[i].size)
+        {
+            return OS_ERROR_DEVICE_NOT_PRESENT;
+        }
+        data     += len;
+        left     -= len;
+        *written += len;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+OS_Error_t
+doReadv(
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    uint8_t*                            data,
+    size_t*                       const read)
+{
+    OS_Error_t err;
+
+    *read = 0U;
+
+    if (!isMediumPresent()) {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((err = DiskMedium_read(extents[i].offset, data,
+                                   extents[i].size)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        data  += extents[i].size;
+        *read += extents[i].size;
+    }
+
+    return OS_SUCCESS;
+}
+
+/*
+ * Complete an operation which started at the given time: let the timing model
+ * delay it (if it was successful) and account it in the statistics.
+ */
+static
+void
+complete(
+    RemovableDisk_Op_t const op,
+    uint32_t           const cmds,
+    uint64_t           const bytes,
+    uint64_t           const start,
+    OS_Error_t         const err)
+{
+    if (err == OS_SUCCESS)
+    {
+        DiskTiming_complete(op, cmds, bytes, start);
+    }
+    DiskStats_record(op, (err == OS_SUCCESS) ? bytes : 0,
+                     DiskTimer_getTimeNs() - start, err);
+}
+
+static
+void
+traceExtents(
+    RemovableDisk_Op_t            const op,
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    uint64_t                      const start)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        DiskTrace_record(op, extents[i].offset, extents[i].size, start);
+    }
+}
+
+/*
+ * Issue the operation of a trace entry; the data written is a fixed pattern,
+ * the data read is thrown away.
+ */
+static
+OS_Error_t
+replayEntry(
+    const RemovableDisk_TraceEntry_t* const entry)
+{
+    static uint8_t scratch[RemovableDisk_TRACE_MAX_SIZE];
+    uint64_t const start = DiskTimer_getTimeNs();
+    size_t done = 0;
+    off_t erased = 0;
+    OS_Error_t err;
+
+    if (((entry->op == RemovableDisk_Op_READ)
+         || (entry->op == RemovableDisk_Op_WRITE))
+        && (entry->size > sizeof(scratch)))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    switch (entry->op)
+    {
+    case RemovableDisk_Op_READ:
+        err = doRead(entry->offset, scratch, entry->size, &done);
+        break;
+    case RemovableDisk_Op_WRITE:
+        memset(scratch, 0xA5, entry->size);
+        err = doWrite(entry->offset, scratch, entry->size, &done);
+        break;
+    case RemovableDisk_Op_ERASE:
+        err = doErase(entry->offset, entry->size, &erased);
+        done = erased;
+        break;
+    case RemovableDisk_Op_GET_SIZE:
+        err = isMediumPresent() ? OS_SUCCESS : OS_ERROR_DEVICE_NOT_PRESENT;
+        break;
+    default:
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    complete(entry->op, 1, done, start, err);
+
+    return err;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskIo_init(
+    void)
+{
+    DiskMedium_init();
+    DiskImage_load();
+    DiskTiming_init();
+    DiskDirty_init();
+}
+
+void
+DiskIo_triggerRemoval(
+    int const ops)
+{
+    io_lock_lock();
+    opsCountdown = ops;
+    io_lock_unlock();
+}
+
+void
+DiskIo_powerCut(
+    int const mods,
+    int const cut)
+{
+    io_lock_lock();
+    DiskPower_cut(mods, cut);
+    io_lock_unlock();
+}
+
+OS_Error_t
+DiskIo_write(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size,
+    size_t*     const written)
+{
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    OS_Error_t const err = doWrite(offset, buf, size, written);
+    complete(RemovableDisk_Op_WRITE, 1, *written, start, err);
+    DiskTrace_record(RemovableDisk_Op_WRITE, offset, size, start);
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_read(
+    off_t   const offset,
+    void*   const buf,
+    size_t  const size,
+    size_t* const read)
+{
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    OS_Error_t const err = doRead(offset, buf, size, read);
+    complete(RemovableDisk_Op_READ, 1, *read, start, err);
+    DiskTrace_record(RemovableDisk_Op_READ, offset, size, start);
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_erase(
+    off_t  const offset,
+    off_t  const size,
+    off_t* const erased)
+{
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    OS_Error_t const err = doErase(offset, size, erased);
+    complete(RemovableDisk_Op_ERASE, 1, *erased, start, err);
+    DiskTrace_record(RemovableDisk_Op_ERASE, offset, size, start);
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_getSize(
+    off_t* const size)
+{
+    OS_Error_t err = OS_SUCCESS;
+
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    if (!isMediumPresent()) {
+        err = OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    else
+    {
+        *size = DiskMedium_getSize();
+    }
+    complete(RemovableDisk_Op_GET_SIZE, 1, 0, start, err);
+    DiskTrace_record(RemovableDisk_Op_GET_SIZE, 0, 0, start);
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_getBlockSize(
+    size_t* const blockSize)
+{
+    *blockSize = DiskMedium_getBlockSize();
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+DiskIo_getState(
+    uint32_t* const flags)
+{
+    OS_Error_t err = OS_ERROR_NOT_SUPPORTED;
+
+    io_lock_lock();
+
+    if (!isMediumPresent()) {
+        err = OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    else
+    {
+        *flags = 0U;
+    }
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_writev(
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    const void*                   const buf,
+    size_t*                       const written)
+{
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    OS_Error_t const err = doWritev(extents, count, buf, written);
+    complete(RemovableDisk_Op_WRITE, count, *written, start, err);
+    traceExtents(RemovableDisk_Op_WRITE, extents, count, start);
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_readv(
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    void*                         const buf,
+    size_t*                       const read)
+{
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    OS_Error_t const err = doReadv(extents, count, buf, read);
+    complete(RemovableDisk_Op_READ, count, *read, start, err);
+    traceExtents(RemovableDisk_Op_READ, extents, count, start);
+
+    io_lock_unlock();
+
+    return err;
+}
+
+bool
+DiskIo_isValidArea(
+    off_t const offset,
+    off_t const size)
+{
+    return DiskMedium_isValidArea(offset, size);
+}
+
+void
+DiskIo_getStats(
+    RemovableDisk_Stats_t* const stats)
+{
+    io_lock_lock();
+
+    memcpy(stats, DiskStats_get(), sizeof(*stats));
+    stats->allocated = DiskMedium_getAllocated()
+                       + DiskSnapshot_getAllocated();
+
+    io_lock_unlock();
+}
+
+void
+DiskIo_resetStats(
+    void)
+{
+    io_lock_lock();
+    DiskStats_reset();
+    io_lock_unlock();
+}
+
+void
+DiskIo_setTrace(
+    bool const enable)
+{
+    io_lock_lock();
+    DiskTrace_enable(enable);
+    io_lock_unlock();
+}
+
+size_t
+DiskIo_getTrace(
+    size_t                      const first,
+    RemovableDisk_TraceEntry_t* const dst,
+    size_t                      const max,
+    size_t*                     const total,
+    size_t*                     const dropped)
+{
+    size_t count;
+
+    io_lock_lock();
+
+    count    = DiskTrace_get(first, dst, max);
+    *total   = DiskTrace_getCount();
+    *dropped = DiskTrace_getDropped();
+
+    io_lock_unlock();
+
+    return count;
+}
+
+OS_Error_t
+DiskIo_replay(
+    const RemovableDisk_TraceEntry_t* const entries,
+    size_t                            const count,
+    uint64_t*                         const ns)
+{
+    OS_Error_t err = OS_SUCCESS;
+
+    io_lock_lock();
+
+    uint64_t const start = DiskTimer_getTimeNs();
+    for (size_t i = 0; (i < count) && (err == OS_SUCCESS); i++)
+    {
+        // Replayed operations must not end up in a trace being captured
+        err = replayEntry(&entries[i]);
+    }
+    *ns = DiskTimer_getTimeNs() - start;
+
+    io_lock_unlock();
+
+    return err;
+}
+
+OS_Error_t
+DiskIo_digest(
+    off_t     const offset,
+    off_t     const size,
+    uint64_t* const digest)
+{
+    static uint8_t chunk[4096];
+    uint64_t hash = 0xcbf29ce484222325ULL;  // FNV-1a 64 offset basis
+    off_t pos = offset, left = size;
+    OS_Error_t err = OS_SUCCESS;
+
+    if (!DiskMedium_isValidArea(offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    io_lock_lock();
+
+    while ((left > 0) && (err == OS_SUCCESS))
+    {
+        size_t const len = (left < (off_t)sizeof(chunk)) ?
+                           (size_t)left : sizeof(chunk);
+
+        if ((err = DiskMedium_read(pos, chunk, len)) == OS_SUCCESS)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                hash = (hash ^ chunk[i]) * 0x100000001b3ULL;
+            }
+        }
+
+        pos  += len;
+        left -= len;
+    }
+
+    io_lock_unlock();
+
+    *digest = hash;
+
+    return err;
+}
+
+uint64_t
+DiskIo_getGeneration(
+    void)
+{
+    uint64_t generation;
+
+    io_lock_lock();
+    generation = DiskDirty_getGeneration();
+    io_lock_unlock();
+
+    return generation;
+}
+
+size_t
+DiskIo_getDirty(
+    RemovableDisk_DirtyMap_t* const dst,
+    size_t                    const max)
+{
+    size_t const size = DiskDirty_getMapSize();
+
+    if (size > max)
+    {
+        return 0;
+    }
+
+    io_lock_lock();
+    DiskDirty_getMap(dst);
+    io_lock_unlock();
+
+    return size;
+}
+
+void
+DiskIo_resetDirty(
+    void)
+{
+    io_lock_lock();
+    DiskDirty_reset();
+    io_lock_unlock();
+}
+
+void
+DiskIo_takeSnapshot(
+    void)
+{
+    io_lock_lock();
+    DiskSnapshot_take();
+    io_lock_unlock();
+}
+
+OS_Error_t
+DiskIo_restoreSnapshot(
+    size_t* const blocks)
+{
+    OS_Error_t err;
+
+    io_lock_lock();
+    err = DiskSnapshot_restore(blocks);
+    io_lock_unlock();
+
+    return err;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "OS_Error.h"
+#include "RemovableDisk.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * The I/O core of the disk: every access to the medium goes through here, no
+ * matter if it came in via the storage RPC, the vectored calls or the async
+ * rings. It does the removal emulation, the bounds checks, the timing model
+ * and the statistics. All calls are serialized, as they may come from the
+ * threads of different interfaces.
+ */
+
+void
+DiskIo_init(
+    void);
+
+/**
+ * Pretend the medium is removed after the given number of operations; see
+ * disk_rpc_triggerRemoval().
+ */
+void
+DiskIo_triggerRemoval(
+    int const ops);
+
+/**
+ * Cut the power during a later write or erase; see disk_rpc_powerCut().
+ */
+void
+DiskIo_powerCut(
+    int const mods,
+    int const cut);
+
+OS_Error_t
+DiskIo_write(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size,
+    size_t*     const written);
+
+OS_Error_t
+DiskIo_read(
+    off_t   const offset,
+    void*   const buf,
+    size_t  const size,
+    size_t* const read);
+
+OS_Error_t
+DiskIo_erase(
+    off_t  const offset,
+    off_t  const size,
+    off_t* const erased);
+
+OS_Error_t
+DiskIo_getSize(
+    off_t* const size);
+
+OS_Error_t
+DiskIo_getBlockSize(
+    size_t* const blockSize);
+
+OS_Error_t
+DiskIo_getState(
+    uint32_t* const flags);
+
+/**
+ * Write count extents in one operation, the data of the extents is taken from
+ * buf in the order of the extents. The extents must have been checked to be
+ * within the medium and buf to be large enough.
+ */
+OS_Error_t
+DiskIo_writev(
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    const void*                   const buf,
+    size_t*                       const written);
+
+OS_Error_t
+DiskIo_readv(
+    const RemovableDisk_Extent_t* const extents,
+    size_t                        const count,
+    void*                         const buf,
+    size_t*                       const read);
+
+/**
+ * Check if the area is within the medium.
+ */
+bool
+DiskIo_isValidArea(
+    off_t const offset,
+    off_t const size);
+
+/**
+ * Get a consistent copy of the statistics, including the current memory use
+ * of the medium.
+ */
+void
+DiskIo_getStats(
+    RemovableDisk_Stats_t* const stats);
+
+void
+DiskIo_resetStats(
+    void);
+
+/**
+ * Start (and clear) or stop capturing the storage operations.
+ */
+void
+DiskIo_setTrace(
+    bool const enable);
+
+/**
+ * Get a consistent chunk of the trace, see DiskTrace_get(); also returns the
+ * number of entries captured and dropped so far.
+ */
+size_t
+DiskIo_getTrace(
+    size_t                      const first,
+    RemovableDisk_TraceEntry_t* const dst,
+    size_t                      const max,
+    size_t*                     const total,
+    size_t*                     const dropped);
+
+/**
+ * Issue the operations of count trace entries without delay between them; the
+ * timing model and the statistics apply as usual. Stops at the first error.
+ */
+OS_Error_t
+DiskIo_replay(
+    const RemovableDisk_TraceEntry_t* const entries,
+    size_t                            const count,
+    uint64_t*                         const ns);
+
+/**
+ * Compute a 64-bit FNV-1a hash over an area of the medium. It bypasses the
+ * removal emulation, the timing model, the statistics and the trace, as it is
+ * meant for checking the content of the disk, not for accessing it.
+ */
+OS_Error_t
+DiskIo_digest(
+    off_t     const offset,
+    off_t     const size,
+    uint64_t* const digest);
+
+uint64_t
+DiskIo_getGeneration(
+    void);
+
+/**
+ * Copy the dirty map into dst if it fits into max bytes. Returns the size of
+ * the map, or 0 if it does not fit.
+ */
+size_t
+DiskIo_getDirty(
+    RemovableDisk_DirtyMap_t* const dst,
+    size_t                    const max);
+
+void
+DiskIo_resetDirty(
+    void);
+
+/**
+ * Take a snapshot of the medium, see DiskSnapshot_take().
+ */
+void
+DiskIo_takeSnapshot(
+    void);
+
+/**
+ * Restore the snapshot, see DiskSnapshot_restore(). Like the digest, this
+ * bypasses the removal emulation, the timing model, the statistics and the
+ * trace; it does count as a modification, though.
+ */
+OS_Error_t
+DiskIo_restoreSnapshot(
+    size_t* const blocks);
@@ -0,0 +1,448 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_medium.h"
+
+#include "lib_debug/Debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <camkes.h>
+
+#define STORAGE_SIZE    CAMKES_CONST_ATTR(storage_size)
+#define IS_SPARSE       (CAMKES_CONST_ATTR(storage_sparse) != 0)
+
+#if defined(RemovableDisk_HOST)
+
+#include "host_image.h"
+
+/*
+ * Flat backend of the host build: the medium is an image file mapped into
+ * memory, see host/.
+ */
+static uint8_t* storage;
+#define FLAT_SIZE   STORAGE_SIZE
+
+#else
+
+/*
+ * Flat backend: the whole medium is one static array, so all of it is part of
+ * the component's memory from the start. With the sparse backend it shrinks to
+ * a single byte.
+ */
+static uint8_t storage[IS_SPARSE ? 1 : STORAGE_SIZE] = { 0u };
+#define FLAT_SIZE   sizeof(storage)
+
+#endif
+
+/*
+ * Sparse backend: the medium is split into pages which are allocated from the
+ * heap on first write; pages which were never written (or were erased
+ * completely) read as 0xFF. The pages are found via a two-level table, where
+ * only the first level is static and the second level tables are allocated
+ * on demand as well. The amount of data the disk can hold is thus limited by
+ * the heap size of the instance, not by storage_size.
+ */
+#define SPARSE_PAGE_SIZE        4096
+#define SPARSE_TABLE_ENTRIES    1024
+#define SPARSE_TABLE_SPAN       \
+    ((uint64_t)SPARSE_PAGE_SIZE * SPARSE_TABLE_ENTRIES)
+#define SPARSE_DIR_ENTRIES      \
+    (IS_SPARSE ? ((STORAGE_SIZE + SPARSE_TABLE_SPAN - 1) / SPARSE_TABLE_SPAN) : 1)
+
+static uint8_t** sparseDir[SPARSE_DIR_ENTRIES];
+static uint64_t sparsePages;
+
+static const uint32_t flashEraseSize =
+    CAMKES_CONST_ATTR(flash_erase_block_size);
+static const uint32_t flashWriteSize =
+    CAMKES_CONST_ATTR(flash_write_granularity);
+
+#define IS_FLASH    (flashEraseSize > 0)
+
+// Private Functions -----------------------------------------------------------
+
+static
+bool
+isAligned(
+    off_t const value,
+    off_t const alignment)
+{
+    return (alignment <= 1) || ((value % alignment) == 0);
+}
+
+/*
+ * Unlike value % base in the checks, this never divides by a constant 0 (the
+ * flash attributes are 0 if not in flash mode), which compilers reject.
+ */
+static
+bool
+isMultiple(
+    uint64_t const value,
+    uint64_t const base)
+{
+    return (base > 0) && ((value % base) == 0);
+}
+
+static
+bool
+isErased(
+    const uint8_t* const buf,
+    size_t         const size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (buf[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static
+uint8_t*
+getPage(
+    uint64_t const idx,
+    bool     const alloc)
+{
+    uint8_t*** const table = &sparseDir[idx / SPARSE_TABLE_ENTRIES];
+    uint8_t** page;
+
+    if (NULL == *table)
+    {
+        if (!alloc)
+        {
+            return NULL;
+        }
+        if ((*table = calloc(SPARSE_TABLE_ENTRIES, sizeof(**table))) == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    page = &(*table)[idx % SPARSE_TABLE_ENTRIES];
+    if ((NULL == *page) && alloc)
+    {
+        if ((*page = malloc(SPARSE_PAGE_SIZE)) == NULL)
+        {
+            Debug_LOG_ERROR("Out of memory after %ju pages",
+                            (uintmax_t)sparsePages);
+            return NULL;
+        }
+        memset(*page, 0xFF, SPARSE_PAGE_SIZE);
+        sparsePages++;
+    }
+
+    return *page;
+}
+
+static
+void
+freePage(
+    uint64_t const idx)
+{
+    uint8_t** const table = sparseDir[idx / SPARSE_TABLE_ENTRIES];
+
+    if ((NULL != table) && (NULL != table[idx % SPARSE_TABLE_ENTRIES]))
+    {
+        free(table[idx % SPARSE_TABLE_ENTRIES]);
+        table[idx % SPARSE_TABLE_ENTRIES] = NULL;
+        sparsePages--;
+    }
+}
+
+static
+void
+programBytes(
+    uint8_t*       const dst,
+    const uint8_t* const src,
+    size_t         const size,
+    bool           const raw)
+{
+    if (!IS_FLASH || raw)
+    {
+        memcpy(dst, src, size);
+        return;
+    }
+
+    // Programming flash can only turn bits from 1 to 0
+    for (size_t i = 0; i < size; i++)
+    {
+        dst[i] &= src[i];
+    }
+}
+
+static
+OS_Error_t
+sparseWrite(
+    off_t          const offset,
+    const uint8_t*       src,
+    size_t               size,
+    bool           const raw)
+{
+    uint64_t pos = offset;
+
+    while (size > 0)
+    {
+        size_t const inPage = pos % SPARSE_PAGE_SIZE;
+        size_t const len    = (size < (SPARSE_PAGE_SIZE - inPage)) ?
+                              size : (SPARSE_PAGE_SIZE - inPage);
+        uint8_t* page       = getPage(pos / SPARSE_PAGE_SIZE, false);
+
+        // Writing 0xFF to a page which is not there would not change a thing
+        if ((NULL == page) && !isErased(src, len))
+        {
+            if ((page = getPage(pos / SPARSE_PAGE_SIZE, true)) == NULL)
+            {
+                return OS_ERROR_INSUFFICIENT_SPACE;
+            }
+        }
+        if (NULL != page)
+        {
+            programBytes(&page[inPage], src, len, raw);
+        }
+
+        pos  += len;
+        src  += len;
+        size -= len;
+    }
+
+    return OS_SUCCESS;
+}
+
+static
+void
+sparseRead(
+    off_t    const offset,
+    uint8_t*       dst,
+    size_t         size)
+{
+    uint64_t pos = offset;
+
+    while (size > 0)
+    {
+        size_t const inPage = pos % SPARSE_PAGE_SIZE;
+        size_t const len    = (size < (SPARSE_PAGE_SIZE - inPage)) ?
+                              size : (SPARSE_PAGE_SIZE - inPage);
+        const uint8_t* const page = getPage(pos / SPARSE_PAGE_SIZE, false);
+
+        if (NULL != page)
+        {
+            memcpy(dst, &page[inPage], len);
+        }
+        else
+        {
+            memset(dst, 0xFF, len);
+        }
+
+        pos  += len;
+        dst  += len;
+        size -= len;
+    }
+}
+
+static
+void
+sparseErase(
+    off_t const offset,
+    off_t       size)
+{
+    uint64_t pos = offset;
+
+    while (size > 0)
+    {
+        size_t const inPage = pos % SPARSE_PAGE_SIZE;
+        size_t const len    = ((uint64_t)size < (SPARSE_PAGE_SIZE - inPage)) ?
+                              (size_t)size : (SPARSE_PAGE_SIZE - inPage);
+
+        if (len == SPARSE_PAGE_SIZE)
+        {
+            // An erased page is the same as a page which does not exist
+            freePage(pos / SPARSE_PAGE_SIZE);
+        }
+        else
+        {
+            uint8_t* const page = getPage(pos / SPARSE_PAGE_SIZE, false);
+            if (NULL != page)
+            {
+                memset(&page[inPage], 0xFF, len);
+            }
+        }
+
+        pos  += len;
+        size -= len;
+    }
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskMedium_init(
+    void)
+{
+#if defined(RemovableDisk_HOST)
+    if (!IS_SPARSE)
+    {
+        // A new image comes erased in flash mode, like a new flash chip
+        storage = HostImage_map(STORAGE_SIZE, IS_FLASH ? 0xFF : 0x00);
+    }
+#endif
+
+    if (IS_SPARSE)
+    {
+        Debug_LOG_INFO("Sparse medium: %ju bytes in pages of %u bytes",
+                       (uintmax_t)STORAGE_SIZE, SPARSE_PAGE_SIZE);
+    }
+
+    if (!IS_FLASH)
+    {
+        return;
+    }
+
+    Debug_ASSERT(flashWriteSize > 0);
+    Debug_ASSERT(isMultiple(STORAGE_SIZE, flashEraseSize));
+    Debug_ASSERT(isMultiple(flashEraseSize, flashWriteSize));
+
+#if !defined(RemovableDisk_HOST)
+    // A new flash chip comes erased; the sparse medium is erased already
+    if (!IS_SPARSE)
+    {
+        memset(storage, 0xFF, sizeof(storage));
+    }
+#endif
+
+    Debug_LOG_INFO("NOR flash mode: erase block %u bytes, write granularity "
+                   "%u bytes", flashEraseSize, flashWriteSize);
+}
+
+bool
+DiskMedium_isValidArea(
+    off_t const offset,
+    off_t const size)
+{
+    uintmax_t const end = (uintmax_t)offset + (uintmax_t)size;
+
+    return ((offset >= 0)
+            && (size >= 0)
+            && (end >= offset)
+            && (end <= STORAGE_SIZE));
+}
+
+off_t
+DiskMedium_getSize(
+    void)
+{
+    return STORAGE_SIZE;
+}
+
+uint64_t
+DiskMedium_getAllocated(
+    void)
+{
+    return IS_SPARSE ? (sparsePages * SPARSE_PAGE_SIZE) : FLAT_SIZE;
+}
+
+size_t
+DiskMedium_getBlockSize(
+    void)
+{
+    return IS_FLASH ? flashEraseSize : 1U;
+}
+
+size_t
+DiskMedium_getWriteSize(
+    void)
+{
+    return IS_FLASH ? flashWriteSize : 1U;
+}
+
+OS_Error_t
+DiskMedium_write(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size)
+{
+    if (IS_FLASH
+        && (!isAligned(offset, flashWriteSize)
+            || !isAligned(size, flashWriteSize)))
+    {
+        Debug_LOG_DEBUG("Write of %zu bytes at %jd is not aligned to %u",
+                        size, (intmax_t)offset, flashWriteSize);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if (IS_SPARSE)
+    {
+        return sparseWrite(offset, buf, size, false);
+    }
+
+    programBytes(&storage[offset], buf, size, false);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+DiskMedium_load(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size)
+{
+    if (IS_SPARSE)
+    {
+        return sparseWrite(offset, buf, size, true);
+    }
+
+    memcpy(&storage[offset], buf, size);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+DiskMedium_read(
+    off_t  const offset,
+    void*  const buf,
+    size_t const size)
+{
+    if (IS_SPARSE)
+    {
+        sparseRead(offset, buf, size);
+        return OS_SUCCESS;
+    }
+
+    memcpy(buf, &storage[offset], size);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+DiskMedium_erase(
+    off_t const offset,
+    off_t const size)
+{
+    if (IS_FLASH
+        && (!isAligned(offset, flashEraseSize)
+            || !isAligned(size, flashEraseSize)))
+    {
+        Debug_LOG_DEBUG("Erase of %jd bytes at %jd is not aligned to %u",
+                        (intmax_t)size, (intmax_t)offset, flashEraseSize);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if (IS_SPARSE)
+    {
+        sparseErase(offset, size);
+        return OS_SUCCESS;
+    }
+
+    memset(&storage[offset], 0xFF, size);
+
+    return OS_SUCCESS;
+}
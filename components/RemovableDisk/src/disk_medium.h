@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * The medium is the memory backing the disk. It is either one static array
+ * (zero-filled at start) or, if the instance has a non-zero storage_sparse
+ * attribute, a set of pages allocated on first write (reading as 0xFF until
+ * then).
+ *
+ * It either behaves like RAM (any byte can be overwritten at any time) or, if
+ * the instance has a non-zero flash_erase_block_size attribute, like NOR
+ * flash:
+ * - writes must be aligned to flash_write_granularity and can only clear bits,
+ * - erase must cover whole erase blocks and sets all bits,
+ * - the block size reported is the erase block size.
+ *
+ * All functions expect the area to be within the medium (see
+ * DiskMedium_isValidArea()).
+ */
+
+void
+DiskMedium_init(
+    void);
+
+bool
+DiskMedium_isValidArea(
+    off_t const offset,
+    off_t const size);
+
+off_t
+DiskMedium_getSize(
+    void);
+
+size_t
+DiskMedium_getBlockSize(
+    void);
+
+/**
+ * Get the granularity writes must be aligned to, 1 if it is not flash.
+ */
+size_t
+DiskMedium_getWriteSize(
+    void);
+
+/**
+ * Get the number of bytes of memory currently used to hold the medium.
+ */
+uint64_t
+DiskMedium_getAllocated(
+    void);
+
+OS_Error_t
+DiskMedium_write(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size);
+
+/**
+ * Set the content of an area as it is, without the alignment rules and the
+ * bit semantics of flash; used to put back content saved before.
+ */
+OS_Error_t
+DiskMedium_load(
+    off_t       const offset,
+    const void* const buf,
+    size_t      const size);
+
+OS_Error_t
+DiskMedium_read(
+    off_t  const offset,
+    void*  const buf,
+    size_t const size);
+
+OS_Error_t
+DiskMedium_erase(
+    off_t const offset,
+    off_t const size);
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "OS_Error.h"
+#include "OS_Dataport.h"
+#include "RemovableDisk.h"
+
+#include "disk_io.h"
+#include "disk_medium.h"
+#include "disk_partition.h"
+
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+typedef struct
+{
+    off_t         offset;
+    off_t         size;
+    OS_Dataport_t port;
+} Partition_t;
+
+#define PARTITION(_n_)                                          \
+    {                                                           \
+        .offset = CAMKES_CONST_ATTR(part ## _n_ ## _offset),    \
+        .size   = CAMKES_CONST_ATTR(part ## _n_ ## _size),      \
+        .port   = OS_DATAPORT_ASSIGN(part ## _n_ ## _port),     \
+    }
+
+static const Partition_t partitions[RemovableDisk_MAX_PARTITIONS] =
+{
+    PARTITION(0),
+    PARTITION(1),
+    PARTITION(2),
+    PARTITION(3),
+};
+
+// Private Functions -----------------------------------------------------------
+
+// The dataports are optional, they are NULL if a partition is not connected
+static
+bool
+isPresent(
+    const Partition_t* const p)
+{
+    return (p->size > 0) && (OS_Dataport_getBuf(p->port) != NULL);
+}
+
+static
+bool
+isValidArea(
+    const Partition_t* const p,
+    off_t              const offset,
+    off_t              const size)
+{
+    uintmax_t const end = (uintmax_t)offset + (uintmax_t)size;
+
+    return ((offset >= 0)
+            && (size >= 0)
+            && (end >= offset)
+            && (end <= p->size));
+}
+
+static
+OS_Error_t
+partWrite(
+    const Partition_t* const p,
+    off_t              const offset,
+    size_t             const size,
+    size_t*            const written)
+{
+    *written = 0U;
+
+    if (!isPresent(p))
+    {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    if (size > OS_Dataport_getSize(p->port))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (!isValidArea(p, offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    return DiskIo_write(p->offset + offset, OS_Dataport_getBuf(p->port), size,
+                        written);
+}
+
+static
+OS_Error_t
+partRead(
+    const Partition_t* const p,
+    off_t              const offset,
+    size_t             const size,
+    size_t*            const read)
+{
+    *read = 0U;
+
+    if (!isPresent(p))
+    {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    if (size > OS_Dataport_getSize(p->port))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (!isValidArea(p, offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    return DiskIo_read(p->offset + offset, OS_Dataport_getBuf(p->port), size,
+                       read);
+}
+
+static
+OS_Error_t
+partErase(
+    const Partition_t* const p,
+    off_t              const offset,
+    off_t              const size,
+    off_t*             const erased)
+{
+    *erased = 0;
+
+    if (!isPresent(p))
+    {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+    if (!isValidArea(p, offset, size))
+    {
+        return OS_ERROR_OUT_OF_BOUNDS;
+    }
+
+    return DiskIo_erase(p->offset + offset, size, erased);
+}
+
+static
+OS_Error_t
+partGetSize(
+    const Partition_t* const p,
+    off_t*             const size)
+{
+    off_t diskSize;
+    OS_Error_t err;
+
+    if (!isPresent(p))
+    {
+        return OS_ERROR_DEVICE_NOT_PRESENT;
+    }
+
+    // Still ask the disk, so medium removal affects partitions as well
+    if ((err = DiskIo_getSize(&diskSize)) == OS_SUCCESS)
+    {
+        *size = p->size;
+    }
+
+    return err;
+}
+
+/*
+ * The RPC functions of partition _n_ just pick the partition and pass the call
+ * on to the functions above.
+ */
+#define DEFINE_PARTITION_RPC(_n_)                                           \
+                                                                            \
+    OS_Error_t                                                              \
+    NONNULL_ALL                                                             \
+    part ## _n_ ## _rpc_write(                                              \
+        off_t   const offset,                                               \
+        size_t  const size,                                                 \
+        size_t* const written)                                              \
+    {                                                                       \
+        return partWrite(&partitions[_n_], offset, size, written);          \
+    }                                                                       \
+                                                                            \
+    OS_Error_t                                                              \
+    NONNULL_ALL                                                             \
+    part ## _n_ ## _rpc_read(                                               \
+        off_t   const offset,                                               \
+        size_t  const size,                                                 \
+        size_t* const read)                                                 \
+    {                                                                       \
+        return partRead(&partitions[_n_], offset, size, read);              \
+    }                                                                       \
+                                                                            \
+    OS_Error_t                                                              \
+    NONNULL_ALL                                                             \
+    part ## _n_ ## _rpc_erase(                                              \
+        off_t  const offset,                                                \
+        off_t  const size,                                                  \
+        off_t* const erased)                                                \
+    {                                                                       \
+        return partErase(&partitions[_n_], offset, size, erased);           \
+    }                                                                       \
+                                                                            \
+    OS_Error_t                                                              \
+    NONNULL_ALL                                                             \
+    part ## _n_ ## _rpc_getSize(                                            \
+        off_t* const size)                                                  \
+    {                                                                       \
+        return partGetSize(&partitions[_n_], size);                         \
+    }                                                                       \
+                                                                            \
+    OS_Error_t                                                              \
+    NONNULL_ALL                                                             \
+    part ## _n_ ## _rpc_getBlockSize(                                       \
+        size_t* const blockSize)                                            \
+    {                                                                       \
+        return DiskIo_getBlockSize(blockSize);                              \
+    }                                                                       \
+                                                                            \
+    OS_Error_t                                                              \
+    NONNULL_ALL                                                             \
+    part ## _n_ ## _rpc_getState(                                           \
+        uint32_t* flags)                                                    \
+    {                                                                       \
+        return isPresent(&partitions[_n_]) ?                                \
+               DiskIo_getState(flags) : OS_ERROR_DEVICE_NOT_PRESENT;        \
+    }
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskPartition_init(
+    void)
+{
+    size_t const blockSize = DiskMedium_getBlockSize();
+
+    for (unsigned int i = 0; i < RemovableDisk_MAX_PARTITIONS; i++)
+    {
+        const Partition_t* const p = &partitions[i];
+
+        if (!isPresent(p))
+        {
+            continue;
+        }
+
+        Debug_ASSERT(DiskMedium_isValidArea(p->offset, p->size));
+        Debug_ASSERT((p->offset % blockSize) == 0);
+        Debug_ASSERT((p->size % blockSize) == 0);
+
+        for (unsigned int j = 0; j < i; j++)
+        {
+            const Partition_t* const q = &partitions[j];
+
+            if ((q->size > 0)
+                && (p->offset < (q->offset + q->size))
+                && (q->offset < (p->offset + p->size)))
+            {
+                Debug_LOG_WARNING("Partition %u overlaps partition %u", i, j);
+            }
+        }
+
+        Debug_LOG_INFO("Partition %u: %jd bytes at %jd", i,
+                       (intmax_t)p->size, (intmax_t)p->offset);
+    }
+}
+
+DEFINE_PARTITION_RPC(0)
+DEFINE_PARTITION_RPC(1)
+DEFINE_PARTITION_RPC(2)
+DEFINE_PARTITION_RPC(3)
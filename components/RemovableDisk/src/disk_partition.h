@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+/*
+ * The storage interfaces part0_rpc to part3_rpc, each covering the window of
+ * the medium set by the partN_offset and partN_size attributes. Offsets in
+ * calls are relative to the start of the window; all operations go through
+ * the I/O core, so they serialize with those of the other interfaces.
+ */
+
+/**
+ * Check and log the partition table.
+ */
+void
+DiskPartition_init(
+    void);
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_power.h"
+
+#include "lib_debug/Debug.h"
+
+#include <stdint.h>
+
+static int modsCountdown = -1;
+static int cutBytes;
+static bool isFrozen;
+// The random cuts are the same on every run
+static uint32_t rndState = 0x5EED2024;
+
+// Private Functions -----------------------------------------------------------
+
+static
+uint32_t
+nextRandom(
+    void)
+{
+    rndState ^= rndState << 13;
+    rndState ^= rndState >> 17;
+    rndState ^= rndState << 5;
+
+    return rndState;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskPower_cut(
+    int const mods,
+    int const cut)
+{
+    modsCountdown = mods;
+    cutBytes      = cut;
+    isFrozen      = false;
+}
+
+bool
+DiskPower_isFrozen(
+    void)
+{
+    return isFrozen;
+}
+
+size_t
+DiskPower_getThrough(
+    size_t const size,
+    size_t const granularity)
+{
+    size_t through;
+
+    if (modsCountdown < 0)
+    {
+        return size;
+    }
+    if (modsCountdown > 0)
+    {
+        modsCountdown--;
+        return size;
+    }
+
+    through = (cutBytes < 0) ?
+              ((size > 0) ? (nextRandom() % size) : 0) :
+              (((size_t)cutBytes < size) ? (size_t)cutBytes : size);
+    if (granularity > 1)
+    {
+        through -= through % granularity;
+    }
+
+    Debug_LOG_INFO("Power cut after %zu of %zu bytes", through, size);
+
+    modsCountdown = -1;
+    isFrozen      = true;
+
+    return through;
+}
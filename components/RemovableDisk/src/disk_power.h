@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Power cut emulation: once armed, the power fails during a later write or
+ * erase. Only the bytes before the cut reach the medium, then the medium is
+ * frozen, i.e., it keeps its content and every operation fails as if the disk
+ * was gone, until the power is restored.
+ */
+
+/**
+ * Arm a power cut during the modification which follows the given number of
+ * successful ones. If cut is negative, a random byte of it is picked,
+ * otherwise cut bytes get through (all of them if it is not that large).
+ * A negative number of modifications restores the power and disarms.
+ */
+void
+DiskPower_cut(
+    int const mods,
+    int const cut);
+
+bool
+DiskPower_isFrozen(
+    void);
+
+/**
+ * Account a modification of size bytes that is about to be done. Returns how
+ * many bytes of it get through, rounded down to the granularity. If the power
+ * fails during it, the medium is frozen afterwards, even if all bytes got
+ * through.
+ */
+size_t
+DiskPower_getThrough(
+    size_t const size,
+    size_t const granularity);
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_snapshot.h"
+#include "disk_dirty.h"
+#include "disk_medium.h"
+
+#include "lib_debug/Debug.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <camkes.h>
+
+#define STORAGE_SIZE    CAMKES_CONST_ATTR(storage_size)
+#define BLOCK_SIZE      CAMKES_CONST_ATTR(dirty_block_size)
+#define BLOCKS          ((STORAGE_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE)
+
+typedef struct Saved
+{
+    struct Saved* next;
+    uint64_t      block;
+    uint8_t       data[];
+} Saved_t;
+
+// Bit set for every block which is in the saved list
+static uint8_t savedMap[(BLOCKS + 7) / 8];
+static Saved_t* savedList;
+static size_t savedCount;
+static bool isTaken;
+
+// Private Functions -----------------------------------------------------------
+
+static
+size_t
+getBlockLength(
+    uint64_t const block)
+{
+    // The last block may be cut short by the end of the medium
+    uint64_t const left = STORAGE_SIZE - (block * BLOCK_SIZE);
+
+    return (left < BLOCK_SIZE) ? (size_t)left : BLOCK_SIZE;
+}
+
+static
+void
+dropSaved(
+    void)
+{
+    while (NULL != savedList)
+    {
+        Saved_t* const next = savedList->next;
+        free(savedList);
+        savedList = next;
+    }
+
+    memset(savedMap, 0, sizeof(savedMap));
+    savedCount = 0;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskSnapshot_take(
+    void)
+{
+    dropSaved();
+    isTaken = true;
+}
+
+OS_Error_t
+DiskSnapshot_save(
+    off_t const offset,
+    off_t const size)
+{
+    OS_Error_t err;
+
+    if (!isTaken || (size == 0))
+    {
+        return OS_SUCCESS;
+    }
+
+    for (uint64_t blk = offset / BLOCK_SIZE;
+         blk <= (uint64_t)(offset + size - 1) / BLOCK_SIZE; blk++)
+    {
+        Saved_t* saved;
+
+        if (savedMap[blk / 8] & (1u << (blk % 8)))
+        {
+            continue;
+        }
+
+        if ((saved = malloc(sizeof(*saved) + BLOCK_SIZE)) == NULL)
+        {
+            Debug_LOG_ERROR("Out of memory for snapshot after %zu blocks",
+                            savedCount);
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        if ((err = DiskMedium_read(blk * BLOCK_SIZE, saved->data,
+                                   getBlockLength(blk))) != OS_SUCCESS)
+        {
+            free(saved);
+            return err;
+        }
+
+        saved->block = blk;
+        saved->next  = savedList;
+        savedList    = saved;
+        savedMap[blk / 8] |= (uint8_t)(1u << (blk % 8));
+        savedCount++;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+DiskSnapshot_restore(
+    size_t* const blocks)
+{
+    OS_Error_t err;
+
+    *blocks = 0;
+
+    if (!isTaken)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    for (const Saved_t* saved = savedList; NULL != saved; saved = saved->next)
+    {
+        off_t const offset = saved->block * BLOCK_SIZE;
+        size_t const len   = getBlockLength(saved->block);
+
+        if ((err = DiskMedium_load(offset, saved->data, len)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        DiskDirty_mark(offset, len);
+    }
+
+    // The content is that of the snapshot again, so nothing needs to be kept
+    *blocks = savedCount;
+    dropSaved();
+
+    return OS_SUCCESS;
+}
+
+uint64_t
+DiskSnapshot_getAllocated(
+    void)
+{
+    return (uint64_t)savedCount * BLOCK_SIZE;
+}
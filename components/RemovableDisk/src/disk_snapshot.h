@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Copy-on-write snapshot of the medium: taking a snapshot costs nothing, but
+ * afterwards every block (of dirty_block_size bytes) is saved to the heap
+ * before it is modified the first time. Restoring puts back only the saved
+ * blocks, so it takes time (and memory) proportional to what was changed.
+ * There is a single snapshot, it remains valid after it was restored.
+ */
+
+/**
+ * Take a snapshot of the current content, replacing the previous one.
+ */
+void
+DiskSnapshot_take(
+    void);
+
+/**
+ * Save the blocks of an area which is about to be modified, if they were not
+ * saved before. Fails if there is no memory left for saving them.
+ */
+OS_Error_t
+DiskSnapshot_save(
+    off_t const offset,
+    off_t const size);
+
+/**
+ * Put back the content of the snapshot; blocks is the number of blocks which
+ * had to be restored.
+ */
+OS_Error_t
+DiskSnapshot_restore(
+    size_t* const blocks);
+
+/**
+ * Get the number of bytes of memory used for saved blocks.
+ */
+uint64_t
+DiskSnapshot_getAllocated(
+    void);
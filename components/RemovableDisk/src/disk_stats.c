@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_stats.h"
+
+#include "lib_debug/Debug.h"
+
+#include <string.h>
+
+static RemovableDisk_Stats_t stats;
+
+// Private Functions -----------------------------------------------------------
+
+static
+unsigned int
+getBucket(
+    uint64_t ns)
+{
+    unsigned int bucket = 0;
+
+    // Bucket i covers [2^i, 2^(i+1)) ns, bucket 0 also gets everything < 1ns
+    while ((ns >>= 1) && (bucket < (RemovableDisk_STATS_BUCKETS - 1)))
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskStats_record(
+    RemovableDisk_Op_t const op,
+    uint64_t           const bytes,
+    uint64_t           const ns,
+    OS_Error_t         const err)
+{
+    Debug_ASSERT(op < RemovableDisk_Op_NUM);
+
+    RemovableDisk_OpStats_t* const s = &stats.ops[op];
+
+    s->calls++;
+    if (err != OS_SUCCESS)
+    {
+        s->errors++;
+    }
+    s->bytes   += bytes;
+    s->ns      += ns;
+    s->latency[getBucket(ns)]++;
+}
+
+const RemovableDisk_Stats_t*
+DiskStats_get(
+    void)
+{
+    return &stats;
+}
+
+void
+DiskStats_reset(
+    void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
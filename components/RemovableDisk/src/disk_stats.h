@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "OS_Error.h"
+#include "RemovableDisk.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Account one storage operation of type op, which moved the given number of
+ * bytes and took ns nanoseconds to complete with result err.
+ */
+void
+DiskStats_record(
+    RemovableDisk_Op_t const op,
+    uint64_t           const bytes,
+    uint64_t           const ns,
+    OS_Error_t         const err);
+
+/**
+ * Get a pointer to the current statistics.
+ */
+const RemovableDisk_Stats_t*
+DiskStats_get(
+    void);
+
+/**
+ * Clear all statistics.
+ */
+void
+DiskStats_reset(
+    void);
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_timer.h"
+
+#include "OS_Error.h"
+#include "TimeServer.h"
+
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+static const if_OS_Timer_t timer =
+    IF_OS_TIMER_ASSIGN(
+        timeServer_rpc,
+        timeServer_notify);
+
+// Public Functions ------------------------------------------------------------
+
+uint64_t
+DiskTimer_getTimeNs(
+    void)
+{
+    OS_Error_t err;
+    uint64_t ns;
+
+    if ((err = TimeServer_getTime(&timer, TimeServer_PRECISION_NSEC,
+                                  &ns)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("TimeServer_getTime() failed, code %d", err);
+        return 0;
+    }
+
+    return ns;
+}
+
+void
+DiskTimer_sleepNs(
+    uint64_t const ns)
+{
+    OS_Error_t err;
+
+    if ((err = TimeServer_sleep(&timer, TimeServer_PRECISION_NSEC,
+                                ns)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("TimeServer_sleep() failed, code %d", err);
+    }
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Get a monotonic timestamp in nanoseconds from the TimeServer; returns 0 if
+ * the TimeServer cannot be reached.
+ */
+uint64_t
+DiskTimer_getTimeNs(
+    void);
+
+/**
+ * Block the calling thread for (at least) the given number of nanoseconds.
+ */
+void
+DiskTimer_sleepNs(
+    uint64_t const ns);
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_timing.h"
+#include "disk_timer.h"
+
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+/*
+ * The model is simple: every operation costs a fixed latency plus the time
+ * needed to move the data at the configured bandwidth. A bandwidth of 0 means
+ * "unlimited", so with all attributes left at their default of 0 the disk
+ * behaves like the plain RAM disk it has always been.
+ */
+typedef struct
+{
+    uint32_t latencyUs;
+    uint32_t kibps;
+} DiskTiming_OpModel_t;
+
+static const DiskTiming_OpModel_t models[RemovableDisk_Op_NUM] =
+{
+    [RemovableDisk_Op_READ] = {
+        .latencyUs  = CAMKES_CONST_ATTR(timing_read_latency_us),
+        .kibps      = CAMKES_CONST_ATTR(timing_read_kibps),
+    },
+    [RemovableDisk_Op_WRITE] = {
+        .latencyUs  = CAMKES_CONST_ATTR(timing_write_latency_us),
+        .kibps      = CAMKES_CONST_ATTR(timing_write_kibps),
+    },
+    [RemovableDisk_Op_ERASE] = {
+        .latencyUs  = CAMKES_CONST_ATTR(timing_erase_latency_us),
+        .kibps      = CAMKES_CONST_ATTR(timing_erase_kibps),
+    },
+    // Querying the size is answered by the controller, it is free
+    [RemovableDisk_Op_GET_SIZE] = {
+        .latencyUs  = 0,
+        .kibps      = 0,
+    },
+};
+
+// Private Functions -----------------------------------------------------------
+
+static
+uint64_t
+getCostNs(
+    RemovableDisk_Op_t const op,
+    uint32_t           const cmds,
+    uint64_t           const bytes)
+{
+    const DiskTiming_OpModel_t* const m = &models[op];
+    uint64_t ns = (uint64_t)cmds * m->latencyUs * 1000ULL;
+
+    if (m->kibps > 0)
+    {
+        ns += (bytes * 1000000000ULL) / ((uint64_t)m->kibps * 1024ULL);
+    }
+
+    return ns;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskTiming_init(
+    void)
+{
+    Debug_LOG_INFO("Timing model: "
+                   "read %uus + %u KiB/s, "
+                   "write %uus + %u KiB/s, "
+                   "erase %uus + %u KiB/s",
+                   models[RemovableDisk_Op_READ].latencyUs,
+                   models[RemovableDisk_Op_READ].kibps,
+                   models[RemovableDisk_Op_WRITE].latencyUs,
+                   models[RemovableDisk_Op_WRITE].kibps,
+                   models[RemovableDisk_Op_ERASE].latencyUs,
+                   models[RemovableDisk_Op_ERASE].kibps);
+}
+
+void
+DiskTiming_complete(
+    RemovableDisk_Op_t const op,
+    uint32_t           const cmds,
+    uint64_t           const bytes,
+    uint64_t           const start)
+{
+    Debug_ASSERT(op < RemovableDisk_Op_NUM);
+
+    uint64_t const cost = getCostNs(op, cmds, bytes);
+    uint64_t now;
+
+    if (cost == 0)
+    {
+        return;
+    }
+
+    // Only wait for what is left of the modeled cost; the copying we did
+    // already took some time as well
+    now = DiskTimer_getTimeNs();
+    if ((now - start) < cost)
+    {
+        DiskTimer_sleepNs(cost - (now - start));
+    }
+}
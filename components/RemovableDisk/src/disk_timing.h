@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "RemovableDisk.h"
+
+#include <stdint.h>
+
+/**
+ * Log the device timing model configured for this instance.
+ */
+void
+DiskTiming_init(
+    void);
+
+/**
+ * Delay the completion of an operation so that it takes as long as it would
+ * on the emulated device. The operation consists of cmds device commands
+ * (more than one for vectored I/O), each paying the fixed latency. The time
+ * already spent since start (in ns, as returned by DiskTimer_getTimeNs()) is
+ * deducted from the modeled cost.
+ */
+void
+DiskTiming_complete(
+    RemovableDisk_Op_t const op,
+    uint32_t           const cmds,
+    uint64_t           const bytes,
+    uint64_t           const start);
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#include "disk_trace.h"
+
+#include "lib_debug/Debug.h"
+
+#include <string.h>
+#include <camkes.h>
+
+#define TRACE_ENTRIES   CAMKES_CONST_ATTR(trace_entries)
+
+// Like the flat medium, a disabled trace shrinks to a single entry
+static RemovableDisk_TraceEntry_t trace[(TRACE_ENTRIES > 0) ?
+                                        TRACE_ENTRIES : 1];
+static size_t traceCount;
+static size_t traceDropped;
+static uint64_t traceStart;
+static bool isEnabled;
+
+// Public Functions ------------------------------------------------------------
+
+void
+DiskTrace_enable(
+    bool const enable)
+{
+    if (enable)
+    {
+        if (TRACE_ENTRIES == 0)
+        {
+            Debug_LOG_WARNING("Trace buffer has no entries, see "
+                              "RemovableDisk_TRACE()");
+        }
+        traceCount   = 0;
+        traceDropped = 0;
+        // The first operation captured defines the time 0
+        traceStart   = 0;
+    }
+    else if (traceDropped > 0)
+    {
+        Debug_LOG_WARNING("Trace buffer full, %zu operations dropped",
+                          traceDropped);
+    }
+
+    isEnabled = enable;
+}
+
+void
+DiskTrace_record(
+    RemovableDisk_Op_t const op,
+    off_t              const offset,
+    uint64_t           const size,
+    uint64_t           const start)
+{
+    RemovableDisk_TraceEntry_t* e;
+
+    if (!isEnabled)
+    {
+        return;
+    }
+    if (traceCount >= TRACE_ENTRIES)
+    {
+        traceDropped++;
+        return;
+    }
+    if (traceCount == 0)
+    {
+        traceStart = start;
+    }
+
+    e = &trace[traceCount++];
+    e->ns     = start - traceStart;
+    e->offset = offset;
+    e->size   = size;
+    e->op     = op;
+}
+
+size_t
+DiskTrace_get(
+    size_t                      const first,
+    RemovableDisk_TraceEntry_t* const dst,
+    size_t                      const max)
+{
+    size_t count;
+
+    if (first >= traceCount)
+    {
+        return 0;
+    }
+
+    count = ((traceCount - first) < max) ? (traceCount - first) : max;
+    memcpy(dst, &trace[first], count * sizeof(*dst));
+
+    return count;
+}
+
+size_t
+DiskTrace_getCount(
+    void)
+{
+    return traceCount;
+}
+
+size_t
+DiskTrace_getDropped(
+    void)
+{
+    return traceDropped;
+}
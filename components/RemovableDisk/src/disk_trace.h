@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+
+#pragma once
+
+#include "RemovableDisk.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Capture of the storage operations in a buffer of trace_entries entries.
+ * When the buffer is full, further operations are only counted as dropped.
+ */
+
+/**
+ * Clear the buffer and start capturing, or stop capturing.
+ */
+void
+DiskTrace_enable(
+    bool const enable);
+
+/**
+ * Capture an operation if enabled; start is the time it was issued at, as
+ * returned by DiskTimer_getTimeNs().
+ */
+void
+DiskTrace_record(
+    RemovableDisk_Op_t const op,
+    off_t              const offset,
+    uint64_t           const size,
+    uint64_t           const start);
+
+/**
+ * Copy up to max captured entries, beginning with entry first, to dst.
+ * Returns the number of entries copied.
+ */
+size_t
+DiskTrace_get(
+    size_t                      const first,
+    RemovableDisk_TraceEntry_t* const dst,
+    size_t                      const max);
+
+size_t
+DiskTrace_getCount(
+    void);
+
+size_t
+DiskTrace_getDropped(
+    void);
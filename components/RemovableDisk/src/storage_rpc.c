@@ -8,6 +8,12 @@
 
 
 #include "OS_Error.h"
+#include "OS_Dataport.h"
+#include "RemovableDisk.h"
+
+#include "disk_async.h"
+#include "disk_io.h"
+#include "disk_partition.h"
 
 #include "lib_debug/Debug.h"
 
@@ -17,51 +23,63 @@
 
 #include "system_config.h"
 
-static uint8_t storage[CAMKES_CONST_ATTR(storage_size)] = { 0u };
-
-static int opsCountdown = -1;
+static const OS_Dataport_t port     = OS_DATAPORT_ASSIGN(storage_port);
+static const OS_Dataport_t diskPort = OS_DATAPORT_ASSIGN(disk_port);
 
 // Private Functions -----------------------------------------------------------
 
+/*
+ * Copy the extent table out of the dataport (so the client cannot change it
+ * while we work on it) and check it.
+ */
 static
-bool
-isValidStorageArea(
-    off_t const offset,
-    off_t const size)
+OS_Error_t
+getExtents(
+    RemovableDisk_Extent_t* const extents,
+    size_t                  const count)
 {
-    uintmax_t const end = (uintmax_t)offset + (uintmax_t)size;
+    size_t const hdr = count * sizeof(*extents);
+    size_t sum = 0;
 
-    return ((offset >= 0)
-            && (size >= 0)
-            && (end >= offset)
-            && (end <= sizeof(storage)));
-}
+    if ((count == 0) || (count > RemovableDisk_MAX_EXTENTS))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if (hdr > OS_Dataport_getSize(diskPort))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
 
-static
-bool
-isMediumPresent(
-    void)
-{
-    /*
-     * This has three behaviors:
-     * 1. If opsCountdown == 0, medium is not present
-     * 2. If opsCountdown != 0, medium is present
-     * 2.1 Count down to 0 if opsCountdown > 0
-     * 2.2 Just leave the opsCountdown value if < 0; this allows to leave the
-     *     disk in a permanent "ready" mode.
-     */
+    memcpy(extents, OS_Dataport_getBuf(diskPort), hdr);
 
-    if (!opsCountdown) {
-        return false;
-    }
-    if (opsCountdown > 0) {
-        opsCountdown = opsCountdown - 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!DiskIo_isValidArea(extents[i].offset, extents[i].size))
+        {
+            return OS_ERROR_OUT_OF_BOUNDS;
+        }
+        sum += extents[i].size;
+        if ((sum < extents[i].size)
+            || (sum > (OS_Dataport_getSize(diskPort) - hdr)))
+        {
+            return OS_ERROR_BUFFER_TOO_SMALL;
+        }
     }
-    return true;
+
+    return OS_SUCCESS;
 }
 
 // Public Functions ------------------------------------------------------------
 
+void
+post_init(
+    void)
+{
+    DiskIo_init();
+    DiskPartition_init();
+    DiskAsync_init();
+}
+
 OS_Error_t
 NONNULL_ALL
 storage_rpc_write(
@@ -69,19 +87,7 @@ storage_rpc_write(
     size_t  const size,
     size_t* const written)
 {
-    if (!isMediumPresent()) {
-        return OS_ERROR_DEVICE_NOT_PRESENT;
-    }
-    if (!isValidStorageArea(offset, size))
-    {
-        *written = 0U;
-        return OS_ERROR_OUT_OF_BOUNDS;
-    }
-
-    memcpy(&storage[offset], storage_port, size);
-    *written = size;
-
-    return OS_SUCCESS;
+    return DiskIo_write(offset, OS_Dataport_getBuf(port), size, written);
 }
 
 OS_Error_t
@@ -91,19 +97,7 @@ storage_rpc_read(
     size_t  const size,
     size_t* const read)
 {
-    if (!isMediumPresent()) {
-        return OS_ERROR_DEVICE_NOT_PRESENT;
-    }
-    if (!isValidStorageArea(offset, size))
-    {
-        *read = 0U;
-        return OS_ERROR_OUT_OF_BOUNDS;
-    }
-
-    memcpy(storage_port, &storage[offset], size);
-    *read = size;
-
-    return OS_SUCCESS;
+    return DiskIo_read(offset, OS_Dataport_getBuf(port), size, read);
 }
 
 OS_Error_t
@@ -113,20 +107,7 @@ storage_rpc_erase(
     off_t  const size,
     off_t* const erased)
 {
-    *erased = 0;
-
-    if (!isMediumPresent()) {
-        return OS_ERROR_DEVICE_NOT_PRESENT;
-    }
-    if (!isValidStorageArea(offset, size))
-    {
-        return OS_ERROR_OUT_OF_BOUNDS;
-    }
-
-    memset(&storage[offset], 0xFF, size);
-    *erased = size;
-
-    return OS_SUCCESS;
+    return DiskIo_erase(offset, size, erased);
 }
 
 OS_Error_t
@@ -134,13 +115,7 @@ NONNULL_ALL
 storage_rpc_getSize(
     off_t* const size)
 {
-    if (!isMediumPresent()) {
-        return OS_ERROR_DEVICE_NOT_PRESENT;
-    }
-
-    *size = sizeof(storage);
-
-    return OS_SUCCESS;
+    return DiskIo_getSize(size);
 }
 
 OS_Error_t
@@ -148,8 +123,7 @@ NONNULL_ALL
 storage_rpc_getBlockSize(
     size_t* const blockSize)
 {
-    *blockSize = 1U;
-    return OS_SUCCESS;
+    return DiskIo_getBlockSize(blockSize);
 }
 
 OS_Error_t
@@ -157,12 +131,7 @@ NONNULL_ALL
 storage_rpc_getState(
     uint32_t* flags)
 {
-    if (!isMediumPresent()) {
-        return OS_ERROR_DEVICE_NOT_PRESENT;
-    }
-
-    *flags = 0U;
-    return OS_ERROR_NOT_SUPPORTED;
+    return DiskIo_getState(flags);
 }
 
 OS_Error_t
@@ -178,7 +147,207 @@ disk_rpc_triggerRemoval(
      * there will be no error.
      */
 
-    opsCountdown = ops;
+    DiskIo_triggerRemoval(ops);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+disk_rpc_powerCut(
+    int mods,
+    int cut)
+{
+    /*
+     * Other than a removal, a power cut hits in the middle of a write (or
+     * erase): mods is the number of writes/erases that still complete, in the
+     * next one only the first cut bytes (a random number of them if cut < 0)
+     * reach the medium. Then the medium is frozen until the power is restored
+     * by setting mods < 0.
+     */
+
+    DiskIo_powerCut(mods, cut);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_getStats(
+    size_t* const size)
+{
+    *size = 0;
+
+    if (sizeof(RemovableDisk_Stats_t) > OS_Dataport_getSize(diskPort))
+    {
+        Debug_LOG_ERROR("Stats (%zu bytes) exceed dataport size",
+                        sizeof(RemovableDisk_Stats_t));
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    DiskIo_getStats(OS_Dataport_getBuf(diskPort));
+    *size = sizeof(RemovableDisk_Stats_t);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+disk_rpc_resetStats(
+    void)
+{
+    DiskIo_resetStats();
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_writev(
+    size_t  const count,
+    size_t* const written)
+{
+    static RemovableDisk_Extent_t extents[RemovableDisk_MAX_EXTENTS];
+    void* const buf = OS_Dataport_getBuf(diskPort);
+    OS_Error_t err;
+
+    *written = 0U;
+
+    if ((err = getExtents(extents, count)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    return DiskIo_writev(extents, count,
+                        RemovableDisk_EXTENTS_DATA(buf, count), written);
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_readv(
+    size_t  const count,
+    size_t* const read)
+{
+    static RemovableDisk_Extent_t extents[RemovableDisk_MAX_EXTENTS];
+    void* const buf = OS_Dataport_getBuf(diskPort);
+    OS_Error_t err;
+
+    *read = 0U;
+
+    if ((err = getExtents(extents, count)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    return DiskIo_readv(extents, count,
+                       RemovableDisk_EXTENTS_DATA(buf, count), read);
+}
+
+OS_Error_t
+disk_rpc_setTrace(
+    int enable)
+{
+    DiskIo_setTrace(enable != 0);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_getTrace(
+    size_t  const first,
+    size_t* const count,
+    size_t* const total,
+    size_t* const dropped)
+{
+    *count = DiskIo_getTrace(first, OS_Dataport_getBuf(diskPort),
+                             OS_Dataport_getSize(diskPort)
+                             / sizeof(RemovableDisk_TraceEntry_t),
+                             total, dropped);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_replayTrace(
+    size_t    const count,
+    uint64_t* const ns)
+{
+    static RemovableDisk_TraceEntry_t entries[RemovableDisk_MAX_TRACE_CHUNK];
+
+    *ns = 0;
+
+    if ((count > RemovableDisk_MAX_TRACE_CHUNK)
+        || ((count * sizeof(*entries)) > OS_Dataport_getSize(diskPort)))
+    {
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    // Copy the entries, so the client cannot change them while we work
+    memcpy(entries, OS_Dataport_getBuf(diskPort), count * sizeof(*entries));
+
+    return DiskIo_replay(entries, count, ns);
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_digest(
+    off_t     const offset,
+    off_t     const size,
+    uint64_t* const digest)
+{
+    *digest = 0;
+
+    return DiskIo_digest(offset, size, digest);
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_getGeneration(
+    uint64_t* const generation)
+{
+    *generation = DiskIo_getGeneration();
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_getDirty(
+    size_t* const size)
+{
+    if ((*size = DiskIo_getDirty(OS_Dataport_getBuf(diskPort),
+                                 OS_Dataport_getSize(diskPort))) == 0)
+    {
+        Debug_LOG_ERROR("Dirty map exceeds dataport size, increase "
+                        "dirty_block_size");
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
 
     return OS_SUCCESS;
-}
\ No newline at end of file
+}
+
+OS_Error_t
+disk_rpc_resetDirty(
+    void)
+{
+    DiskIo_resetDirty();
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+disk_rpc_snapshot(
+    void)
+{
+    DiskIo_takeSnapshot();
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+NONNULL_ALL
+disk_rpc_restore(
+    size_t* const blocks)
+{
+    return DiskIo_restoreSnapshot(blocks);
+}
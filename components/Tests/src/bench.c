@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "bench.h"
+
+#include "TimeServer.h"
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+static const if_OS_Timer_t timer =
+    IF_OS_TIMER_ASSIGN(
+        timeServer_rpc,
+        timeServer_notify);
+
+const OS_FileSystem_Format_t bench_littleFsFormat =
+{
+    .littleFs = {
+        .readSize = 4096,
+        .writeSize = 4096,
+        .blockSize = 4096,
+        .blockCycles = 500,
+    }
+};
+
+// Private Functions -----------------------------------------------------------
+
+static void
+printResult(
+    const char* kind,
+    const char* name,
+    const char* fs,
+    uint64_t    value,
+    const char* unit,
+    OS_Error_t  err)
+{
+    // Bypass the decoration of the debug log, the line must be pure JSON
+    printf("{\"result\":\"%s\",\"name\":\"%s\",\"fs\":%s%s%s,"
+           "\"value\":%" PRIu64 ",\"unit\":\"%s\",\"err\":%d}\n",
+           kind, name,
+           (NULL != fs) ? "\"" : "", (NULL != fs) ? fs : "null",
+           (NULL != fs) ? "\"" : "",
+           value, unit, err);
+}
+
+// Public Functions ------------------------------------------------------------
+
+uint64_t
+bench_getTimeNs(
+    void)
+{
+    OS_Error_t err;
+    uint64_t ns;
+
+    if ((err = TimeServer_getTime(&timer, TimeServer_PRECISION_NSEC,
+                                  &ns)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("TimeServer_getTime() failed, code %d", err);
+        return 0;
+    }
+
+    return ns;
+}
+
+uint32_t
+bench_getRandom(
+    uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state;
+}
+
+void
+bench_fillPattern(
+    uint8_t* buf,
+    uint32_t key,
+    off_t    pos,
+    size_t   len)
+{
+    for (size_t i = 0; i < len; i++, pos++)
+    {
+        buf[i] = (uint8_t)((key * 31) + (pos ^ (pos >> 8)));
+    }
+}
+
+uint64_t
+bench_getKiBps(
+    uint64_t bytes,
+    uint64_t ns)
+{
+    if (ns == 0)
+    {
+        return 0;
+    }
+
+    // Scale bytes first to keep precision; fine for up to ~18 GB moved
+    return (bytes * 1000000000ULL) / (ns * 1024ULL);
+}
+
+const char*
+bench_getFsName(
+    OS_FileSystem_Type_t type)
+{
+    switch (type)
+    {
+    case OS_FileSystem_Type_LITTLEFS:
+        return "LITTLEFS";
+    case OS_FileSystem_Type_SPIFFS:
+        return "SPIFFS";
+    case OS_FileSystem_Type_FATFS:
+        return "FATFS";
+    default:
+        break;
+    }
+
+    return "UNKNOWN";
+}
+
+void
+bench_logResult(
+    const char* kind,
+    const char* name,
+    const char* fs,
+    uint64_t    value,
+    const char* unit)
+{
+    printResult(kind, name, fs, value, unit, OS_SUCCESS);
+}
+
+void
+bench_logStep(
+    const char*          name,
+    OS_FileSystem_Type_t type,
+    bool                 removed,
+    uint64_t             start)
+{
+    uint64_t const ns = bench_getTimeNs() - start;
+    char label[64];
+
+    snprintf(label, sizeof(label), "%s%s", name, removed ? ":removed" : "");
+    printResult("step", label, bench_getFsName(type), ns, "ns", OS_SUCCESS);
+}
+
+void
+bench_logScenario(
+    const char* name,
+    uint64_t    start,
+    OS_Error_t  err)
+{
+    printResult("scenario", name, NULL, bench_getTimeNs() - start, "ns", err);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_FileSystem.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * Name of the i-th file on a volume filled for the benchmarks, so volumes
+ * made by one run (e.g. kept as disk image) can be looked into by another.
+ * The size holds any unsigned index, not only the five digits we use.
+ */
+#define bench_FILE_NAME_FMT     "f%05u.bin"
+#define bench_FILE_NAME_SIZE    sizeof("f4294967295.bin")
+
+/**
+ * Format of LittleFS the tests and benchmarks use, unless they are about the
+ * format itself.
+ */
+extern const OS_FileSystem_Format_t bench_littleFsFormat;
+
+/**
+ * Seed of the pseudo-random sequences of the benchmarks, so every run, and
+ * every FS type, sees the same sequence.
+ */
+#define bench_RANDOM_SEED       0x5EED2024u
+
+/**
+ * Get the next number of a pseudo-random sequence (xorshift32) from its state,
+ * which starts out as bench_RANDOM_SEED.
+ */
+uint32_t
+bench_getRandom(
+    uint32_t* state);
+
+/**
+ * Fill a buffer with the test data at a position within a file. Each byte only
+ * depends on its position and the key (e.g. the index of the file), so reads
+ * can be checked no matter what was written before.
+ */
+void
+bench_fillPattern(
+    uint8_t* buf,
+    uint32_t key,
+    off_t    pos,
+    size_t   len);
+
+/**
+ * Get a monotonic timestamp in nanoseconds from the TimeServer.
+ */
+uint64_t
+bench_getTimeNs(
+    void);
+
+/**
+ * Compute a throughput in KiB/s for a number of bytes moved in a given time.
+ * Returns 0 if the time is 0.
+ */
+uint64_t
+bench_getKiBps(
+    uint64_t bytes,
+    uint64_t ns);
+
+/**
+ * Get a short printable name for a filesystem type.
+ */
+const char*
+bench_getFsName(
+    OS_FileSystem_Type_t type);
+
+/**
+ * Print a result as one JSON line on the console, so it can be collected by
+ * tools instead of being scraped from the log. All lines have the same keys:
+ *
+ *   {"result":"<kind>","name":"<name>","fs":"<FS name>"|null,
+ *    "value":<value>,"unit":"<unit>","err":<code>}
+ *
+ * The kind tells what was measured (e.g. "scenario", "step", "metric"), fs is
+ * NULL if the result is not about a FS; err is always 0 here.
+ */
+void
+bench_logResult(
+    const char* kind,
+    const char* name,
+    const char* fs,
+    uint64_t    value,
+    const char* unit);
+
+/**
+ * Print the time since start (from bench_getTimeNs()) of a step of a test as
+ * result of kind "step"; a step run with the disk removed gets ":removed"
+ * appended to its name.
+ */
+void
+bench_logStep(
+    const char*          name,
+    OS_FileSystem_Type_t type,
+    bool                 removed,
+    uint64_t             start);
+
+/**
+ * Print the time since start of a test scenario and the code it returned as
+ * result of kind "scenario".
+ */
+void
+bench_logScenario(
+    const char* name,
+    uint64_t    start,
+    OS_Error_t  err);
@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * The generator first fills the volume with files of mixed sizes up to the
+ * fill level, then churns: it deletes, overwrites, appends to and creates
+ * files, keeping the volume around the fill level. Everything depends on the
+ * seed only, so each FS type sees the very same sequence of operations.
+ *
+ * The content of a file only depends on its index and the position within
+ * it, so reads can be checked no matter what happened to the file before.
+ */
+#define AGING_FILES         96
+#define AGING_FILL_PERCENT  70
+#define AGING_CHURN_OPS     2000
+#define AGING_CHECKPOINTS   4
+#define AGING_RANDOM_READS  256
+#define AGING_CHUNK         512
+
+typedef struct
+{
+    uint32_t rand;
+    off_t    sizes[AGING_FILES];    ///< -1 if the file does not exist
+    uint64_t used;                  ///< sum of the file sizes
+    uint64_t target;                ///< fill level in bytes
+    unsigned int files;
+    unsigned int full;              ///< writes failed with the volume full
+    uint64_t allocNs;               ///< time spent growing files
+    uint64_t allocBytes;            ///< bytes files have grown by
+} Aging_t;
+
+static uint8_t agingBuf[AGING_CHUNK];
+static uint8_t agingExpected[AGING_CHUNK];
+
+// Private Functions -----------------------------------------------------------
+
+static off_t
+getRandomSize(
+    Aging_t* ag)
+{
+    uint32_t const r = bench_getRandom(&ag->rand) % 10;
+
+    // Mostly small files, some medium and a few big ones
+    if (r < 7)
+    {
+        return 256 + bench_getRandom(&ag->rand) % (4 * 1024 - 256);
+    }
+    if (r < 9)
+    {
+        return 4 * 1024 + bench_getRandom(&ag->rand) % (12 * 1024);
+    }
+
+    return 16 * 1024 + bench_getRandom(&ag->rand) % (48 * 1024);
+}
+
+static void
+getName(
+    char*        name,
+    unsigned int idx)
+{
+    snprintf(name, bench_FILE_NAME_SIZE, bench_FILE_NAME_FMT, idx);
+}
+
+/*
+ * Write an area of a file, creating the file if needed. If the FS runs out of
+ * space, the file is deleted, which also makes room for what comes next. Any
+ * failure counts as the FS being full.
+ */
+static void
+writeArea(
+    OS_FileSystem_Handle_t hFs,
+    Aging_t*               ag,
+    unsigned int           idx,
+    off_t                  pos,
+    off_t                  len)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    char name[bench_FILE_NAME_SIZE];
+    uint64_t const start = bench_getTimeNs();
+    OS_Error_t err, errClose;
+    off_t done;
+
+    getName(name, idx);
+    if ((err = OS_FileSystemFile_open(hFs, &hFile, name,
+                                      OS_FileSystem_OpenMode_RDWR,
+                                      OS_FileSystem_OpenFlags_CREATE))
+        != OS_SUCCESS)
+    {
+        // Even creating a file needs some space
+        Debug_LOG_DEBUG("Opening %s failed, code %d", name, err);
+        ag->full++;
+        return;
+    }
+
+    for (done = 0; (done < len) && (err == OS_SUCCESS); done += AGING_CHUNK)
+    {
+        size_t const n = ((len - done) < AGING_CHUNK) ?
+                         (size_t)(len - done) : AGING_CHUNK;
+
+        bench_fillPattern(agingBuf, idx, pos + done, n);
+        err = OS_FileSystemFile_write(hFs, hFile, pos + done, n, agingBuf);
+    }
+
+    // Closing may write as well
+    errClose = OS_FileSystemFile_close(hFs, hFile);
+    err = (err == OS_SUCCESS) ? errClose : err;
+
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_DEBUG("Writing %s failed, code %d", name, err);
+        TEST_SUCCESS(OS_FileSystemFile_delete(hFs, name));
+        if (ag->sizes[idx] >= 0)
+        {
+            ag->used -= ag->sizes[idx];
+            ag->files--;
+        }
+        ag->sizes[idx] = -1;
+        ag->full++;
+        return;
+    }
+
+    if (ag->sizes[idx] < 0)
+    {
+        ag->files++;
+        ag->sizes[idx] = 0;
+    }
+    if ((pos + len) > ag->sizes[idx])
+    {
+        // Only growing a file needs new space from the FS
+        ag->allocNs    += bench_getTimeNs() - start;
+        ag->allocBytes += (pos + len) - ag->sizes[idx];
+        ag->used       += (pos + len) - ag->sizes[idx];
+        ag->sizes[idx]  = pos + len;
+    }
+}
+
+static void
+deleteFile(
+    OS_FileSystem_Handle_t hFs,
+    Aging_t*               ag,
+    unsigned int           idx)
+{
+    char name[bench_FILE_NAME_SIZE];
+
+    getName(name, idx);
+    TEST_SUCCESS(OS_FileSystemFile_delete(hFs, name));
+
+    ag->used -= ag->sizes[idx];
+    ag->sizes[idx] = -1;
+    ag->files--;
+}
+
+/*
+ * Pick a random file which exists (or, if exists is false, which does not);
+ * returns AGING_FILES if there is none.
+ */
+static unsigned int
+pickFile(
+    Aging_t* ag,
+    bool     exists)
+{
+    unsigned int const first = bench_getRandom(&ag->rand) % AGING_FILES;
+
+    for (unsigned int i = 0; i < AGING_FILES; i++)
+    {
+        unsigned int const idx = (first + i) % AGING_FILES;
+
+        if ((ag->sizes[idx] >= 0) == exists)
+        {
+            return idx;
+        }
+    }
+
+    return AGING_FILES;
+}
+
+static void
+doChurn(
+    OS_FileSystem_Handle_t hFs,
+    Aging_t*               ag)
+{
+    uint32_t action = bench_getRandom(&ag->rand) % 100;
+    unsigned int idx;
+    off_t pos, len;
+
+    // Keep the volume around the fill level
+    if ((action >= 50) && (ag->used > ag->target))
+    {
+        action = 0;
+    }
+
+    if (action < 25)
+    {
+        if ((idx = pickFile(ag, true)) < AGING_FILES)
+        {
+            deleteFile(hFs, ag, idx);
+        }
+    }
+    else if (action < 50)
+    {
+        if (((idx = pickFile(ag, true)) < AGING_FILES)
+            && (ag->sizes[idx] > 0))
+        {
+            pos = bench_getRandom(&ag->rand) % ag->sizes[idx];
+            len = 1 + bench_getRandom(&ag->rand) % (ag->sizes[idx] - pos);
+            writeArea(hFs, ag, idx, pos, len);
+        }
+    }
+    else if (action < 75)
+    {
+        if ((idx = pickFile(ag, true)) < AGING_FILES)
+        {
+            len = 256 + bench_getRandom(&ag->rand) % (4 * 1024 - 256);
+            writeArea(hFs, ag, idx, ag->sizes[idx], len);
+        }
+    }
+    else
+    {
+        if ((idx = pickFile(ag, false)) < AGING_FILES)
+        {
+            writeArea(hFs, ag, idx, 0, getRandomSize(ag));
+        }
+    }
+}
+
+static void
+readArea(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile,
+    unsigned int               idx,
+    off_t                      pos,
+    size_t                     len)
+{
+    TEST_SUCCESS(OS_FileSystemFile_read(hFs, hFile, pos, len, agingBuf));
+
+    bench_fillPattern(agingExpected, idx, pos, len);
+    TEST_TRUE(!memcmp(agingBuf, agingExpected, len));
+}
+
+static uint64_t
+readSequential(
+    OS_FileSystem_Handle_t hFs,
+    Aging_t*               ag,
+    uint64_t*              bytes)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    char name[bench_FILE_NAME_SIZE];
+    uint64_t const start = bench_getTimeNs();
+
+    *bytes = 0;
+
+    for (unsigned int idx = 0; idx < AGING_FILES; idx++)
+    {
+        if (ag->sizes[idx] < 0)
+        {
+            continue;
+        }
+
+        getName(name, idx);
+        TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, name,
+                                            OS_FileSystem_OpenMode_RDONLY,
+                                            OS_FileSystem_OpenFlags_NONE));
+        for (off_t pos = 0; pos < ag->sizes[idx]; pos += AGING_CHUNK)
+        {
+            size_t const n = ((ag->sizes[idx] - pos) < AGING_CHUNK) ?
+                             (size_t)(ag->sizes[idx] - pos) : AGING_CHUNK;
+
+            readArea(hFs, hFile, idx, pos, n);
+            *bytes += n;
+        }
+        TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+static uint64_t
+readRandom(
+    OS_FileSystem_Handle_t hFs,
+    Aging_t*               ag,
+    uint64_t*              bytes)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    char name[bench_FILE_NAME_SIZE];
+    uint64_t const start = bench_getTimeNs();
+    unsigned int idx;
+
+    *bytes = 0;
+
+    for (unsigned int i = 0; i < AGING_RANDOM_READS; i++)
+    {
+        if (((idx = pickFile(ag, true)) == AGING_FILES)
+            || (ag->sizes[idx] < AGING_CHUNK))
+        {
+            continue;
+        }
+
+        off_t const pos = bench_getRandom(&ag->rand)
+                          % (ag->sizes[idx] - AGING_CHUNK + 1);
+
+        getName(name, idx);
+        TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, name,
+                                            OS_FileSystem_OpenMode_RDONLY,
+                                            OS_FileSystem_OpenFlags_NONE));
+        readArea(hFs, hFile, idx, pos, AGING_CHUNK);
+        TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+
+        *bytes += AGING_CHUNK;
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+static void
+logCheckpoint(
+    OS_FileSystem_Handle_t hFs,
+    OS_FileSystem_Type_t   type,
+    Aging_t*               ag,
+    unsigned int           ops)
+{
+    uint64_t seqBytes, seqNs, randBytes, randNs;
+
+    seqNs  = readSequential(hFs, ag, &seqBytes);
+    randNs = readRandom(hFs, ag, &randBytes);
+
+    Debug_LOG_INFO("aging %-8s | ops %5u | files %3u | used %7" PRIu64 " B | "
+                   "alloc %8" PRIu64 " ns/KiB | seq %6" PRIu64 " KiB/s | "
+                   "rand %6" PRIu64 " KiB/s | full %3u",
+                   bench_getFsName(type), ops, ag->files, ag->used,
+                   (ag->allocBytes > 0) ?
+                   (ag->allocNs * 1024) / ag->allocBytes : 0,
+                   bench_getKiBps(seqBytes, seqNs),
+                   bench_getKiBps(randBytes, randNs),
+                   ag->full);
+
+    // Allocation time is reported per interval
+    ag->allocNs    = 0;
+    ag->allocBytes = 0;
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Age a freshly formatted FS with a seeded mix of file operations and print
+ * allocation time and sequential/random read throughput at checkpoints. The
+ * files are named as given by bench_FILE_NAME_FMT and are left on the volume;
+ * the aged_image target of the host build runs only this for one FS type, so
+ * the volume can be kept as disk image.
+ */
+void
+bench_Aging_run(
+    OS_FileSystem_Config_t* cfg)
+{
+    static Aging_t ag;
+    OS_FileSystem_Handle_t hFs;
+    unsigned int idx, ops;
+    off_t volumeSize;
+
+    TEST_START("i", cfg->type);
+
+    memset(&ag, 0, sizeof(ag));
+    memset(ag.sizes, 0xFF, sizeof(ag.sizes));
+    ag.rand = bench_RANDOM_SEED;
+
+    TEST_SUCCESS(cfg->storage.getSize(&volumeSize));
+    ag.target = ((uint64_t)volumeSize * AGING_FILL_PERCENT) / 100;
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+
+    // Fill up; the FS may be full before we think it is
+    while ((ag.used < ag.target) && (ag.full == 0)
+           && ((idx = pickFile(&ag, false)) < AGING_FILES))
+    {
+        writeArea(hFs, &ag, idx, 0, getRandomSize(&ag));
+    }
+    logCheckpoint(hFs, cfg->type, &ag, 0);
+
+    for (ops = 1; ops <= AGING_CHURN_OPS; ops++)
+    {
+        doChurn(hFs, &ag);
+
+        if ((ops % (AGING_CHURN_OPS / AGING_CHECKPOINTS)) == 0)
+        {
+            logCheckpoint(hFs, cfg->type, &ag, ops);
+        }
+    }
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    TEST_FINISH();
+}
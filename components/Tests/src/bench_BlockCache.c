@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "BlockCache.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+
+/*
+ * The workload is what small records appended to a log look like: a file is
+ * written in many tiny writes. Without a cache, each write turns into several
+ * read-modify-write cycles on the disk.
+ */
+static const char* cacheFileName = "cachefile.bin";
+static const off_t cacheFileSize = 8 * 1024;
+static const size_t cacheChunk   = 8;
+
+// Private Functions -----------------------------------------------------------
+
+static uint64_t
+writeSmall(
+    OS_FileSystem_Handle_t hFs)
+{
+    static const uint8_t record[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    OS_FileSystemFile_Handle_t hFile;
+    uint64_t start;
+
+    start = bench_getTimeNs();
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, cacheFileName,
+                                        OS_FileSystem_OpenMode_WRONLY,
+                                        OS_FileSystem_OpenFlags_CREATE));
+    for (off_t written = 0; written < cacheFileSize; written += cacheChunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, written, cacheChunk,
+                                             record));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    // The data is only safe once it is on the disk, so the flush belongs to
+    // the measurement
+    TEST_SUCCESS(CACHE_FLUSH);
+
+    return bench_getTimeNs() - start;
+}
+
+static void
+runMode(
+    OS_FileSystem_Config_t* cfg,
+    BlockCache_Mode_t       mode)
+{
+    static RemovableDisk_Stats_t disk;
+    static BlockCache_Stats_t cache;
+    OS_FileSystem_Handle_t hFs;
+    uint64_t ns, blocks;
+
+    TEST_SUCCESS(cache_rpc_setMode(mode));
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+
+    TEST_SUCCESS(CACHE_FLUSH);
+    DISK_STATS_RESET;
+    CACHE_STATS_RESET;
+
+    ns = writeSmall(hFs);
+
+    TEST_SUCCESS(RemovableDisk_getStats(&disk));
+    TEST_SUCCESS(BlockCache_getStats(&cache));
+    blocks = cache.hits + cache.misses;
+
+    Debug_LOG_INFO(
+        "cache %-8s %-10s | %6" PRIu64 " calls | %6" PRIu64 " round-trips | "
+        "%3" PRIu64 "%% hits | %10" PRIu64 " ns",
+        bench_getFsName(cfg->type),
+        (mode == BlockCache_Mode_BYPASS) ? "bypass" : "write-back",
+        cache.reads + cache.writes + cache.erases,
+        disk.ops[RemovableDisk_Op_READ].calls
+        + disk.ops[RemovableDisk_Op_WRITE].calls
+        + disk.ops[RemovableDisk_Op_ERASE].calls,
+        (blocks > 0) ? (cache.hits * 100) / blocks : 0,
+        ns);
+
+    TEST_SUCCESS(OS_FileSystemFile_delete(hFs, cacheFileName));
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    // Flushes and empties the cache, so the next user gets the plain disk
+    TEST_SUCCESS(cache_rpc_setMode(BlockCache_Mode_BYPASS));
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Write a file in tiny chunks once with the block cache bypassed and once
+ * with write-back caching, and print the disk round-trips, the cache hit rate
+ * and the time each takes.
+ */
+void
+bench_BlockCache_smallWrites(
+    OS_FileSystem_Config_t* cfg)
+{
+    TEST_START("i", cfg->type);
+
+    runMode(cfg, BlockCache_Mode_BYPASS);
+    runMode(cfg, BlockCache_Mode_WRITE_BACK);
+
+    TEST_FINISH();
+}
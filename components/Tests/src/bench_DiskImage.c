@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+#include "bench_stats.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * Files are looked up by name in the order they were created; a volume with
+ * fewer files gives misses for the rest, which are timed separately.
+ */
+#define IMAGE_LOOKUPS   1024
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Measure mounting the volume the disk was preloaded with and looking up the
+ * files on it, named as given by bench_FILE_NAME_FMT. Returns false if there
+ * is no volume of the given type on the disk; mounting does not touch it.
+ */
+bool
+bench_DiskImage_preloaded(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+    char name[bench_FILE_NAME_SIZE];
+    uint64_t start, ns, nsMount, nsHit = 0, nsMiss = 0;
+    unsigned int hits = 0, misses = 0;
+    off_t size;
+    OS_Error_t err;
+
+    TEST_START("i", cfg->type);
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+
+    DISK_STATS_RESET;
+    start = bench_getTimeNs();
+    err = OS_FileSystem_mount(hFs);
+    nsMount = bench_getTimeNs() - start;
+
+    if (err != OS_SUCCESS)
+    {
+        TEST_SUCCESS(OS_FileSystem_free(hFs));
+        TEST_FINISH();
+        return false;
+    }
+
+    bench_logDiskStats("image mount", cfg->type);
+
+    for (unsigned int i = 0; i < IMAGE_LOOKUPS; i++)
+    {
+        snprintf(name, sizeof(name), bench_FILE_NAME_FMT, i);
+
+        start = bench_getTimeNs();
+        err = OS_FileSystemFile_getSize(hFs, name, &size);
+        ns = bench_getTimeNs() - start;
+
+        if (err == OS_SUCCESS)
+        {
+            hits++;
+            nsHit += ns;
+        }
+        else
+        {
+            misses++;
+            nsMiss += ns;
+        }
+    }
+
+    bench_logDiskStats("image lookup", cfg->type);
+
+    Debug_LOG_INFO("image %-8s | mount %10" PRIu64 " ns | %4u found "
+                   "%8" PRIu64 " ns/lookup | %4u missing %8" PRIu64
+                   " ns/lookup",
+                   bench_getFsName(cfg->type), nsMount,
+                   hits, (hits > 0) ? nsHit / hits : 0,
+                   misses, (misses > 0) ? nsMiss / misses : 0);
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    TEST_FINISH();
+
+    return true;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+#include "OS_Dataport.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+/*
+ * The traced workload is a complete life cycle of a small file system: format
+ * and mount it, write a file in small chunks, read it back, unmount.
+ */
+static const char* traceFileName = "tracefile.bin";
+static const off_t traceFileSize = 16 * 1024;
+static const size_t traceChunk   = 256;
+
+// Granularity at which hot offsets are reported
+#define HEAT_BLOCK_SIZE     4096
+#define HEAT_BLOCKS         1024
+#define HEAT_TOP            5
+
+static const OS_Dataport_t port = OS_DATAPORT_ASSIGN(disk_port);
+
+static uint32_t heat[HEAT_BLOCKS][RemovableDisk_Op_NUM];
+static uint8_t fileBuf[256];
+
+// Private Functions -----------------------------------------------------------
+
+static void
+runWorkload(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+    OS_FileSystemFile_Handle_t hFile;
+
+    memset(fileBuf, 0x3C, sizeof(fileBuf));
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, traceFileName,
+                                        OS_FileSystem_OpenMode_RDWR,
+                                        OS_FileSystem_OpenFlags_CREATE));
+    for (off_t pos = 0; pos < traceFileSize; pos += traceChunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, pos, traceChunk,
+                                             fileBuf));
+    }
+    for (off_t pos = 0; pos < traceFileSize; pos += traceChunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_read(hFs, hFile, pos, traceChunk,
+                                            fileBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+}
+
+static void
+countHeat(
+    const RemovableDisk_TraceEntry_t* entries,
+    size_t                            count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const RemovableDisk_TraceEntry_t* const e = &entries[i];
+        size_t const blk = (size_t)(e->offset / HEAT_BLOCK_SIZE);
+
+        TEST_TRUE(e->op < RemovableDisk_Op_NUM);
+        if ((e->op != RemovableDisk_Op_GET_SIZE) && (blk < HEAT_BLOCKS))
+        {
+            heat[blk][e->op]++;
+        }
+    }
+}
+
+static void
+logHotOffsets(
+    OS_FileSystem_Type_t type)
+{
+    for (unsigned int n = 0; n < HEAT_TOP; n++)
+    {
+        uint32_t best = 0;
+        size_t bestBlk = 0;
+
+        for (size_t blk = 0; blk < HEAT_BLOCKS; blk++)
+        {
+            uint32_t const sum = heat[blk][RemovableDisk_Op_READ]
+                                 + heat[blk][RemovableDisk_Op_WRITE]
+                                 + heat[blk][RemovableDisk_Op_ERASE];
+            if (sum > best)
+            {
+                best    = sum;
+                bestBlk = blk;
+            }
+        }
+        if (best == 0)
+        {
+            break;
+        }
+
+        Debug_LOG_INFO("trace %-8s hot #%u | offset %8zu | rd %5u | wr %5u | "
+                       "er %5u",
+                       bench_getFsName(type), n + 1,
+                       bestBlk * HEAT_BLOCK_SIZE,
+                       heat[bestBlk][RemovableDisk_Op_READ],
+                       heat[bestBlk][RemovableDisk_Op_WRITE],
+                       heat[bestBlk][RemovableDisk_Op_ERASE]);
+
+        // Take it out of the race for the next place
+        memset(heat[bestBlk], 0, sizeof(heat[bestBlk]));
+    }
+}
+
+/*
+ * Read the captured trace out of the disk chunk by chunk and replay each chunk
+ * right away, so the trace can be as long as the disk was configured for.
+ * Returns the number of entries, the time of the last one and the replay time.
+ */
+static size_t
+replayTrace(
+    uint64_t* capturedNs,
+    uint64_t* replayedNs)
+{
+    const RemovableDisk_TraceEntry_t* const entries =
+        OS_Dataport_getBuf(port);
+    size_t chunk = OS_Dataport_getSize(port) / sizeof(*entries);
+    size_t got = 0, count, total, dropped;
+    uint64_t ns;
+
+    if (chunk > RemovableDisk_MAX_TRACE_CHUNK)
+    {
+        chunk = RemovableDisk_MAX_TRACE_CHUNK;
+    }
+
+    memset(heat, 0, sizeof(heat));
+    *capturedNs = 0;
+    *replayedNs = 0;
+
+    do
+    {
+        TEST_SUCCESS(disk_rpc_getTrace(got, &count, &total, &dropped));
+        count = (count < chunk) ? count : chunk;
+        if (count == 0)
+        {
+            break;
+        }
+
+        countHeat(entries, count);
+        *capturedNs = entries[count - 1].ns;
+
+        // The entries are in the dataport already, the disk replays from there
+        TEST_SUCCESS(disk_rpc_replayTrace(count, &ns));
+        *replayedNs += ns;
+        got += count;
+    }
+    while (got < total);
+
+    // A trace missing operations cannot be compared with the workload
+    if (dropped > 0)
+    {
+        Debug_LOG_ERROR("trace incomplete: disk dropped %zu entries, "
+                        "configure it for more than %zu", dropped, total);
+    }
+    TEST_TRUE(dropped == 0);
+
+    return got;
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Capture the storage operations of a small workload, print where the file
+ * system hits the disk most and replay the trace on the raw disk. Comparing
+ * the replay time against the capture time shows how much of the workload is
+ * spent in the disk rather than in the file system.
+ */
+void
+bench_DiskTrace_captureReplay(
+    OS_FileSystem_Config_t* cfg)
+{
+    static RemovableDisk_Stats_t captured, replayed;
+    size_t count;
+    uint64_t capturedNs, replayedNs;
+
+    TEST_START("i", cfg->type);
+
+    TEST_SUCCESS(DISK_STATS_RESET);
+    TEST_SUCCESS(DISK_TRACE_START);
+    runWorkload(cfg);
+    TEST_SUCCESS(DISK_TRACE_STOP);
+    TEST_SUCCESS(RemovableDisk_getStats(&captured));
+
+    TEST_SUCCESS(DISK_STATS_RESET);
+    count = replayTrace(&capturedNs, &replayedNs);
+    TEST_SUCCESS(RemovableDisk_getStats(&replayed));
+    TEST_TRUE(count > 0);
+
+    logHotOffsets(cfg->type);
+
+    // The replay must hit the disk the same way the workload did
+    for (unsigned int op = 0; op < RemovableDisk_Op_NUM; op++)
+    {
+        TEST_TRUE(replayed.ops[op].calls == captured.ops[op].calls);
+        TEST_TRUE(replayed.ops[op].bytes == captured.ops[op].bytes);
+    }
+
+    Debug_LOG_INFO("trace %-8s | %6zu ops | rd %5" PRIu64 " | wr %5" PRIu64
+                   " | er %5" PRIu64 " | captured %10" PRIu64 " ns | "
+                   "replayed %10" PRIu64 " ns",
+                   bench_getFsName(cfg->type), count,
+                   captured.ops[RemovableDisk_Op_READ].calls,
+                   captured.ops[RemovableDisk_Op_WRITE].calls,
+                   captured.ops[RemovableDisk_Op_ERASE].calls,
+                   capturedNs, replayedNs);
+
+    TEST_FINISH();
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_Dataport.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+#include "bench_FileSystemLoad.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+
+/*
+ * The clients each run their own FS on their own partition, so the only thing
+ * they share is the disk server. Whatever it serializes shows up as the
+ * aggregate throughput not growing with the number of clients.
+ */
+typedef struct
+{
+    void (*start)(void);
+    OS_Dataport_t port;
+} Client_t;
+
+static const Client_t clients[bench_FileSystemLoad_MAX_CLIENTS] =
+{
+    { .start = start0_emit, .port = OS_DATAPORT_ASSIGN(result0) },
+    { .start = start1_emit, .port = OS_DATAPORT_ASSIGN(result1) },
+    { .start = start2_emit, .port = OS_DATAPORT_ASSIGN(result2) },
+    { .start = start3_emit, .port = OS_DATAPORT_ASSIGN(result3) },
+};
+
+// Rounds with the same number of clients, only the last one is reported
+#define ROUNDS_PER_COUNT    3
+
+// Private Functions -----------------------------------------------------------
+
+static bench_FileSystemLoad_Result_t*
+getResult(
+    unsigned int client)
+{
+    return OS_Dataport_getBuf(clients[client].port);
+}
+
+static bool
+isReady(void)
+{
+    for (unsigned int i = 0; i < bench_FileSystemLoad_MAX_CLIENTS; i++)
+    {
+        if (__atomic_load_n(&getResult(i)->ready, __ATOMIC_ACQUIRE) == 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+isRoundDone(
+    unsigned int count,
+    uint32_t     round)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (__atomic_load_n(&getResult(i)->done, __ATOMIC_ACQUIRE) != round)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Get the upper bound of the latency bucket the given percentile of the
+ * operations falls into.
+ */
+static uint64_t
+getPercentileNs(
+    const bench_FileSystemLoad_Result_t* res,
+    unsigned int                         percent)
+{
+    uint64_t const limit = ((uint64_t)res->ops * percent + 99) / 100;
+    uint64_t sum = 0;
+
+    for (unsigned int i = 0; i < bench_FileSystemLoad_BUCKETS; i++)
+    {
+        sum += res->latency[i];
+        if (sum >= limit)
+        {
+            return 2ULL << i;
+        }
+    }
+
+    return res->maxNs;
+}
+
+/*
+ * Start a round on the first count clients at once and wait until all of them
+ * have finished it. All clients are notified through the same event, several
+ * completions may come with a single notification.
+ */
+static uint64_t
+runRound(
+    unsigned int count,
+    uint32_t     round)
+{
+    uint64_t start;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        __atomic_store_n(&getResult(i)->round, round, __ATOMIC_RELEASE);
+    }
+
+    start = bench_getTimeNs();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        clients[i].start();
+    }
+    while (!isRoundDone(count, round))
+    {
+        done_wait();
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+static void
+logRound(
+    unsigned int count,
+    uint64_t     ns)
+{
+    static RemovableDisk_Stats_t stats;
+    uint64_t bytes = 0, diskNs = 0, kibps, busy;
+
+    TEST_SUCCESS(RemovableDisk_getStats(&stats));
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const bench_FileSystemLoad_Result_t* res = getResult(i);
+
+        TEST_SUCCESS(res->err);
+        bytes += res->bytes;
+
+        Debug_LOG_INFO("load %u clients | client %u | %5u ops | mean %8"
+                       PRIu64 " ns | p99 < %8" PRIu64 " ns | max %8"
+                       PRIu64 " ns",
+                       count, i, res->ops,
+                       (res->ops > 0) ? res->ns / res->ops : 0,
+                       getPercentileNs(res, 99), res->maxNs);
+    }
+
+    for (unsigned int op = 0; op < RemovableDisk_Op_NUM; op++)
+    {
+        diskNs += stats.ops[op].ns;
+    }
+
+    kibps = bench_getKiBps(bytes, ns);
+    busy  = (ns > 0) ? (diskNs * 100) / ns : 0;
+
+    // With the disk busy all the time, it is what limits the clients
+    Debug_LOG_INFO("load %u clients | total | %8" PRIu64 " KiB/s | "
+                   "disk busy %3" PRIu64 "%%", count, kibps, busy);
+}
+
+static void
+bench_FileSystemLoad_run(
+    unsigned int count,
+    uint32_t*    round)
+{
+    uint64_t ns = 0;
+
+    TEST_START("i", count);
+
+    for (unsigned int i = 0; i < ROUNDS_PER_COUNT; i++)
+    {
+        // Let the first round warm up the FS of a newly added client
+        TEST_SUCCESS(DISK_STATS_RESET);
+        ns = runRound(count, ++(*round));
+    }
+
+    logRound(count, ns);
+
+    TEST_FINISH();
+}
+
+// Public Functions ------------------------------------------------------------
+
+int run()
+{
+    uint32_t round = 0;
+
+    // All clients share the disk, so wait until none is setting up its FS
+    while (!isReady())
+    {
+        done_wait();
+    }
+
+    for (unsigned int count = 1; count <= bench_FileSystemLoad_MAX_CLIENTS;
+         count++)
+    {
+        bench_FileSystemLoad_run(count, &round);
+    }
+
+    Debug_LOG_INFO("All load benchmarks completed");
+
+    return 0;
+}
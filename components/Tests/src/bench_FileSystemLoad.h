@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stdint.h>
+
+/**
+ * Number of clients the load test system has.
+ */
+#define bench_FileSystemLoad_MAX_CLIENTS    4
+
+/**
+ * Number of buckets in the latency histogram of a client; bucket i counts the
+ * file operations which took [2^i, 2^(i+1)) ns, the last bucket also gets
+ * everything above.
+ */
+#define bench_FileSystemLoad_BUCKETS        32
+
+/**
+ * What a client reports for a round of the load test in its result dataport.
+ * The controller sets the round before it starts the client; the client fills
+ * in the rest and sets done to the round as the last step.
+ *
+ * Before the first round, a client sets ready once its FS is set up (or that
+ * failed) and signals done, so no client is still formatting while others
+ * are measured.
+ */
+typedef struct
+{
+    uint32_t   ready;
+    uint32_t   round;
+    uint32_t   done;
+    OS_Error_t err;         ///< first error of the round, if any
+    uint32_t   ops;         ///< file operations done
+    uint64_t   bytes;       ///< bytes read and written
+    uint64_t   ns;          ///< time from the start to the end of the round
+    uint64_t   maxNs;       ///< longest file operation
+    uint32_t   latency[bench_FileSystemLoad_BUCKETS];
+} bench_FileSystemLoad_Result_t;
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_Dataport.h"
+#include "OS_FileSystem.h"
+
+#include "lib_debug/Debug.h"
+#include "bench.h"
+#include "bench_FileSystemLoad.h"
+
+#include <camkes.h>
+
+#include <string.h>
+
+/*
+ * Each round writes a file in small chunks and reads it back; every file
+ * operation is timed on its own.
+ */
+static const char* loadFileName = "loadfile.bin";
+static const off_t loadFileSize = 32 * 1024;
+static const size_t loadChunk   = 512;
+
+static uint8_t loadBuf[512];
+static uint8_t loadExpected[512];
+
+static OS_FileSystem_Config_t cfg =
+{
+    .type = OS_FileSystem_Type_LITTLEFS,
+    .size = OS_FileSystem_USE_STORAGE_MAX,
+    .format = &bench_littleFsFormat,
+    .storage = IF_OS_STORAGE_ASSIGN(
+        storage_rpc,
+        storage_port),
+};
+
+static const OS_Dataport_t resultPort = OS_DATAPORT_ASSIGN(result_port);
+
+// Private Functions -----------------------------------------------------------
+
+static void
+addLatency(
+    bench_FileSystemLoad_Result_t* res,
+    uint64_t                       ns)
+{
+    unsigned int bucket = 0;
+
+    while (((ns >> 1) > 0) && (bucket < (bench_FileSystemLoad_BUCKETS - 1)))
+    {
+        ns >>= 1;
+        bucket++;
+    }
+
+    res->latency[bucket]++;
+}
+
+/*
+ * Time a single file operation and account for it; after the first error the
+ * round goes on, so the controller still gets its result.
+ */
+static void
+account(
+    bench_FileSystemLoad_Result_t* res,
+    OS_Error_t                     err,
+    uint64_t                       start)
+{
+    uint64_t const ns = bench_getTimeNs() - start;
+
+    if ((err != OS_SUCCESS) && (res->err == OS_SUCCESS))
+    {
+        Debug_LOG_ERROR("Client %d: file operation failed, code %d",
+                        client_id, err);
+        res->err = err;
+    }
+
+    res->ops++;
+    res->bytes += loadChunk;
+    res->maxNs  = (ns > res->maxNs) ? ns : res->maxNs;
+    addLatency(res, ns);
+}
+
+static void
+doRound(
+    OS_FileSystem_Handle_t         hFs,
+    bench_FileSystemLoad_Result_t* res)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    uint64_t start;
+    OS_Error_t err;
+    off_t pos;
+
+    if ((err = OS_FileSystemFile_open(hFs, &hFile, loadFileName,
+                                      OS_FileSystem_OpenMode_RDWR,
+                                      OS_FileSystem_OpenFlags_CREATE))
+        != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Client %d: OS_FileSystemFile_open() failed, code %d",
+                        client_id, err);
+        res->err = err;
+        return;
+    }
+
+    for (pos = 0; pos < loadFileSize; pos += loadChunk)
+    {
+        memset(loadBuf, (int)(client_id + pos / loadChunk), loadChunk);
+        start = bench_getTimeNs();
+        err = OS_FileSystemFile_write(hFs, hFile, pos, loadChunk, loadBuf);
+        account(res, err, start);
+    }
+
+    for (pos = 0; pos < loadFileSize; pos += loadChunk)
+    {
+        start = bench_getTimeNs();
+        err = OS_FileSystemFile_read(hFs, hFile, pos, loadChunk, loadBuf);
+        account(res, err, start);
+
+        memset(loadExpected, (int)(client_id + pos / loadChunk), loadChunk);
+        if ((err == OS_SUCCESS) && memcmp(loadBuf, loadExpected, loadChunk))
+        {
+            Debug_LOG_ERROR("Client %d: read back wrong data at %jd",
+                            client_id, (intmax_t)pos);
+            res->err = (res->err == OS_SUCCESS) ? OS_ERROR_GENERIC : res->err;
+        }
+    }
+
+    if ((err = OS_FileSystemFile_close(hFs, hFile)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Client %d: OS_FileSystemFile_close() failed, code %d",
+                        client_id, err);
+        res->err = (res->err == OS_SUCCESS) ? err : res->err;
+    }
+}
+
+// Public Functions ------------------------------------------------------------
+
+int run()
+{
+    bench_FileSystemLoad_Result_t* const res =
+        OS_Dataport_getBuf(resultPort);
+    OS_FileSystem_Handle_t hFs;
+    OS_Error_t err;
+    uint32_t round;
+    uint64_t start;
+
+    // Set up the FS before the first round, so rounds only see file I/O
+    if (((err = OS_FileSystem_init(&hFs, &cfg)) != OS_SUCCESS)
+        || ((err = OS_FileSystem_format(hFs)) != OS_SUCCESS)
+        || ((err = OS_FileSystem_mount(hFs)) != OS_SUCCESS))
+    {
+        Debug_LOG_ERROR("Client %d: setting up FS failed, code %d",
+                        client_id, err);
+    }
+
+    __atomic_store_n(&res->ready, 1, __ATOMIC_RELEASE);
+    done_emit();
+
+    for (;;)
+    {
+        start_wait();
+
+        start = bench_getTimeNs();
+        round = __atomic_load_n(&res->round, __ATOMIC_ACQUIRE);
+
+        res->ops   = 0;
+        res->bytes = 0;
+        res->maxNs = 0;
+        memset(res->latency, 0, sizeof(res->latency));
+        // A client which failed to set up its FS reports that every round
+        res->err   = err;
+
+        if (err == OS_SUCCESS)
+        {
+            doRound(hFs, res);
+        }
+
+        res->ns = bench_getTimeNs() - start;
+        __atomic_store_n(&res->done, round, __ATOMIC_RELEASE);
+        done_emit();
+    }
+
+    return 0;
+}
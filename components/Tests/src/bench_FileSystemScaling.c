@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * All volumes of the sweep are placed at the start of a single sparse disk of
+ * the largest size; the FS is told to use only the first part of it. Between
+ * two runs the volume is erased, which gives the memory back to the disk.
+ */
+static const size_t volumeSizesMiB[] = { 1, 4, 16, 64, 256 };
+
+static const OS_FileSystem_Type_t fsTypes[] =
+{
+    OS_FileSystem_Type_LITTLEFS,
+    OS_FileSystem_Type_SPIFFS,
+    OS_FileSystem_Type_FATFS,
+};
+
+static const if_OS_Storage_t storage =
+    IF_OS_STORAGE_ASSIGN(
+        storage_rpc,
+        storage_port);
+
+// Private Functions -----------------------------------------------------------
+
+static void
+bench_FileSystemScaling_run(
+    OS_FileSystem_Type_t type,
+    size_t               sizeMiB)
+{
+    static RemovableDisk_Stats_t stats;
+    OS_FileSystem_Config_t cfg =
+    {
+        .type    = type,
+        .size    = sizeMiB * 1024 * 1024,
+        .format  = (type == OS_FileSystem_Type_LITTLEFS) ?
+                   &bench_littleFsFormat : NULL,
+        .storage = storage,
+    };
+    OS_FileSystem_Handle_t hFs;
+    uint64_t start, nsFormat, nsMount;
+    off_t erased;
+    char name[32];
+
+    TEST_START("i", type, "i", (int)sizeMiB);
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, &cfg));
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    nsFormat = bench_getTimeNs() - start;
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    nsMount = bench_getTimeNs() - start;
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    // How much of the volume the FS has written to
+    TEST_SUCCESS(RemovableDisk_getStats(&stats));
+
+    Debug_LOG_INFO("scaling %-8s | %4zu MiB | format %12" PRIu64 " ns | "
+                   "mount %12" PRIu64 " ns | mem %10" PRIu64 " B",
+                   bench_getFsName(type), sizeMiB, nsFormat, nsMount,
+                   stats.allocated);
+
+    snprintf(name, sizeof(name), "format %zu MiB", sizeMiB);
+    bench_logResult("metric", name, bench_getFsName(type), nsFormat, "ns");
+    snprintf(name, sizeof(name), "mount %zu MiB", sizeMiB);
+    bench_logResult("metric", name, bench_getFsName(type), nsMount, "ns");
+
+    TEST_SUCCESS(storage.erase(0, cfg.size, &erased));
+
+    TEST_FINISH();
+}
+
+// Public Functions ------------------------------------------------------------
+
+int run()
+{
+    for (size_t i = 0; i < sizeof(fsTypes) / sizeof(fsTypes[0]); i++)
+    {
+        for (size_t j = 0;
+             j < sizeof(volumeSizesMiB) / sizeof(volumeSizesMiB[0]); j++)
+        {
+            bench_FileSystemScaling_run(fsTypes[i], volumeSizesMiB[j]);
+        }
+    }
+
+    Debug_LOG_INFO("All scaling benchmarks completed");
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+/*
+ * The grid of LittleFS geometries. The block size must be a multiple of both
+ * the read and the write size; read and write sizes are limited by the size
+ * of the storage dataport, as LittleFS does I/O in units of them.
+ */
+static const size_t geoReadSizes[]   = { 256, 1024, 4096 };
+static const size_t geoWriteSizes[]  = { 256, 1024, 4096 };
+static const size_t geoBlockSizes[]  = { 4096, 16384 };
+static const int    geoBlockCycles[] = { 100, 500 };
+
+// The same workload for every geometry: write a file, read it back
+static const char* geoFileName = "geofile.bin";
+static const off_t geoFileSize = 32 * 1024;
+static const size_t geoChunk   = 512;
+
+static uint8_t geoBuf[512];
+
+#define ARRAY_SIZE(_a_) (sizeof(_a_) / sizeof((_a_)[0]))
+
+// Private Functions -----------------------------------------------------------
+
+static uint64_t
+getRoundTrips(void)
+{
+    static RemovableDisk_Stats_t stats;
+
+    TEST_SUCCESS(RemovableDisk_getStats(&stats));
+    TEST_SUCCESS(DISK_STATS_RESET);
+
+    return stats.ops[RemovableDisk_Op_READ].calls
+           + stats.ops[RemovableDisk_Op_WRITE].calls
+           + stats.ops[RemovableDisk_Op_ERASE].calls;
+}
+
+static void
+runGeometry(
+    OS_FileSystem_Config_t*       cfg,
+    const OS_FileSystem_Format_t* fmt)
+{
+    OS_FileSystem_Handle_t hFs;
+    OS_FileSystemFile_Handle_t hFile;
+    uint64_t start, nsMount, nsWrite, nsRead, trips;
+
+    cfg->format = fmt;
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    nsMount = bench_getTimeNs() - start;
+
+    TEST_SUCCESS(DISK_STATS_RESET);
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, geoFileName,
+                                        OS_FileSystem_OpenMode_WRONLY,
+                                        OS_FileSystem_OpenFlags_CREATE));
+    for (off_t pos = 0; pos < geoFileSize; pos += geoChunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, pos, geoChunk,
+                                             geoBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    nsWrite = bench_getTimeNs() - start;
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, geoFileName,
+                                        OS_FileSystem_OpenMode_RDONLY,
+                                        OS_FileSystem_OpenFlags_NONE));
+    for (off_t pos = 0; pos < geoFileSize; pos += geoChunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_read(hFs, hFile, pos, geoChunk,
+                                            geoBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    nsRead = bench_getTimeNs() - start;
+
+    trips = getRoundTrips();
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    Debug_LOG_INFO("geometry %5zu %5zu %6zu %4d | %9" PRIu64 " | %9" PRIu64
+                   " | %6" PRIu64 " | %10" PRIu64,
+                   fmt->littleFs.readSize, fmt->littleFs.writeSize,
+                   fmt->littleFs.blockSize, fmt->littleFs.blockCycles,
+                   bench_getKiBps(geoFileSize, nsWrite),
+                   bench_getKiBps(geoFileSize, nsRead),
+                   trips, nsMount);
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Run the same workload on LittleFS formatted with every geometry of a grid
+ * of read, write and block sizes and block cycles, and print a matrix with
+ * throughput, storage round-trips and mount time of each combination.
+ */
+void
+bench_LittleFsGeometry_sweep(
+    OS_FileSystem_Config_t* cfg)
+{
+    const OS_FileSystem_Format_t* const original = cfg->format;
+    size_t const maxIo = OS_Dataport_getSize(cfg->storage.dataport);
+    OS_FileSystem_Format_t fmt;
+
+    TEST_START("i", cfg->type);
+
+    TEST_TRUE(cfg->type == OS_FileSystem_Type_LITTLEFS);
+
+    memset(geoBuf, 0xC3, sizeof(geoBuf));
+
+    Debug_LOG_INFO("geometry %5s %5s %6s %4s | %9s | %9s | %6s | %10s",
+                   "read", "write", "block", "cyc", "wr KiB/s", "rd KiB/s",
+                   "trips", "mount ns");
+
+    for (size_t r = 0; r < ARRAY_SIZE(geoReadSizes); r++)
+    {
+        for (size_t w = 0; w < ARRAY_SIZE(geoWriteSizes); w++)
+        {
+            for (size_t b = 0; b < ARRAY_SIZE(geoBlockSizes); b++)
+            {
+                for (size_t c = 0; c < ARRAY_SIZE(geoBlockCycles); c++)
+                {
+                    if ((geoReadSizes[r] > maxIo)
+                        || (geoWriteSizes[w] > maxIo)
+                        || (geoBlockSizes[b] % geoReadSizes[r])
+                        || (geoBlockSizes[b] % geoWriteSizes[w]))
+                    {
+                        continue;
+                    }
+
+                    memset(&fmt, 0, sizeof(fmt));
+                    fmt.littleFs.readSize    = geoReadSizes[r];
+                    fmt.littleFs.writeSize   = geoWriteSizes[w];
+                    fmt.littleFs.blockSize   = geoBlockSizes[b];
+                    fmt.littleFs.blockCycles = geoBlockCycles[c];
+
+                    runGeometry(cfg, &fmt);
+                }
+            }
+        }
+    }
+
+    cfg->format = original;
+
+    TEST_FINISH();
+}
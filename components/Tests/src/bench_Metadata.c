@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/*
+ * The volume is populated with empty files in steps; at each step a sample of
+ * the files, spread over all of them, is opened, looked up, closed, deleted
+ * and created again. A FS which cannot hold the next population (e.g. FAT
+ * with its fixed root directory) ends the sweep early.
+ */
+static const unsigned int metaPopulations[] = { 64, 256, 512, 1024, 2048 };
+
+#define META_SAMPLE     64
+
+// Private Functions -----------------------------------------------------------
+
+static uint64_t
+getOpsPerSec(
+    unsigned int ops,
+    uint64_t     ns)
+{
+    return (ns > 0) ? (ops * 1000000000ULL) / ns : 0;
+}
+
+static void
+logMetric(
+    const char*          op,
+    OS_FileSystem_Type_t type,
+    unsigned int         files,
+    unsigned int         ops,
+    uint64_t             ns)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "metadata %s %u", op, files);
+    bench_logResult("metric", name, bench_getFsName(type),
+                    getOpsPerSec(ops, ns), "ops/s");
+}
+
+static OS_Error_t
+createFile(
+    OS_FileSystem_Handle_t hFs,
+    unsigned int           idx,
+    uint64_t*              ns)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    char name[bench_FILE_NAME_SIZE];
+    uint64_t start;
+    OS_Error_t err;
+
+    snprintf(name, sizeof(name), bench_FILE_NAME_FMT, idx);
+
+    start = bench_getTimeNs();
+    err = OS_FileSystemFile_open(hFs, &hFile, name,
+                                 OS_FileSystem_OpenMode_WRONLY,
+                                 OS_FileSystem_OpenFlags_CREATE);
+    *ns += bench_getTimeNs() - start;
+
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    return OS_FileSystemFile_close(hFs, hFile);
+}
+
+/*
+ * Time each kind of operation on the sample of files, which are spread evenly
+ * over the current population.
+ */
+static void
+runSample(
+    OS_FileSystem_Handle_t hFs,
+    OS_FileSystem_Type_t   type,
+    unsigned int           files)
+{
+    static OS_FileSystemFile_Handle_t hFiles[META_SAMPLE];
+    char name[bench_FILE_NAME_SIZE];
+    uint64_t start, nsOpen = 0, nsSize = 0, nsClose = 0, nsDelete = 0;
+    uint64_t nsCreate = 0;
+    off_t size;
+
+    for (unsigned int i = 0; i < META_SAMPLE; i++)
+    {
+        snprintf(name, sizeof(name), bench_FILE_NAME_FMT,
+                 (i * files) / META_SAMPLE);
+
+        start = bench_getTimeNs();
+        TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFiles[i], name,
+                                            OS_FileSystem_OpenMode_RDONLY,
+                                            OS_FileSystem_OpenFlags_NONE));
+        nsOpen += bench_getTimeNs() - start;
+
+        start = bench_getTimeNs();
+        TEST_SUCCESS(OS_FileSystemFile_getSize(hFs, name, &size));
+        nsSize += bench_getTimeNs() - start;
+
+        start = bench_getTimeNs();
+        TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFiles[i]));
+        nsClose += bench_getTimeNs() - start;
+    }
+
+    for (unsigned int i = 0; i < META_SAMPLE; i++)
+    {
+        unsigned int const idx = (i * files) / META_SAMPLE;
+
+        snprintf(name, sizeof(name), bench_FILE_NAME_FMT, idx);
+
+        start = bench_getTimeNs();
+        TEST_SUCCESS(OS_FileSystemFile_delete(hFs, name));
+        nsDelete += bench_getTimeNs() - start;
+
+        // Keep the population; this is a create in a full directory
+        TEST_SUCCESS(createFile(hFs, idx, &nsCreate));
+    }
+
+    Debug_LOG_INFO("metadata %-8s | files %5u | create %7" PRIu64 " | "
+                   "open %7" PRIu64 " | getSize %7" PRIu64 " | "
+                   "close %7" PRIu64 " | delete %7" PRIu64 " ops/s",
+                   bench_getFsName(type), files,
+                   getOpsPerSec(META_SAMPLE, nsCreate),
+                   getOpsPerSec(META_SAMPLE, nsOpen),
+                   getOpsPerSec(META_SAMPLE, nsSize),
+                   getOpsPerSec(META_SAMPLE, nsClose),
+                   getOpsPerSec(META_SAMPLE, nsDelete));
+
+    logMetric("create", type, files, META_SAMPLE, nsCreate);
+    logMetric("open", type, files, META_SAMPLE, nsOpen);
+    logMetric("getSize", type, files, META_SAMPLE, nsSize);
+    logMetric("close", type, files, META_SAMPLE, nsClose);
+    logMetric("delete", type, files, META_SAMPLE, nsDelete);
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Print the rates of create, open, getSize, close and delete of empty files
+ * as the number of files on a freshly formatted FS grows, showing how the
+ * lookup by name scales with the number of directory entries. The rate of
+ * creating the files of each new population is printed as well.
+ */
+void
+bench_Metadata_scaling(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+    unsigned int files = 0, first;
+    OS_Error_t err = OS_SUCCESS;
+    uint64_t ns;
+
+    TEST_START("i", cfg->type);
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+
+    for (size_t i = 0;
+         i < sizeof(metaPopulations) / sizeof(metaPopulations[0]);
+         i++)
+    {
+        for (ns = 0, first = files; files < metaPopulations[i]; files++)
+        {
+            if ((err = createFile(hFs, files, &ns)) != OS_SUCCESS)
+            {
+                break;
+            }
+        }
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_INFO("metadata %-8s | no room for more than %u files, "
+                           "code %d", bench_getFsName(cfg->type), files, err);
+            break;
+        }
+
+        // Growing the population appends to the directory, unlike the sample
+        Debug_LOG_INFO("metadata %-8s | files %5u | populate %7" PRIu64
+                       " ops/s", bench_getFsName(cfg->type), files,
+                       getOpsPerSec(files - first, ns));
+        logMetric("populate", cfg->type, files, files - first, ns);
+
+        runSample(hFs, cfg->type, files);
+    }
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    TEST_FINISH();
+}
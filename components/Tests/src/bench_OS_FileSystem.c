@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+#include "bench_stats.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+static const char* benchFileName = "benchfile.bin";
+// Size of the file written/read for every chunk size of the sweep
+static const off_t benchFileSize = 256 * 1024;
+// Smallest chunk size; the sweep doubles it up to the dataport size
+static const size_t benchMinChunk = 8;
+
+static uint8_t benchBuf[4096];
+
+// Private Functions -----------------------------------------------------------
+
+static void
+fillPattern(
+    uint8_t* buf,
+    size_t   len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = (uint8_t)i;
+    }
+}
+
+static bool
+checkPattern(
+    const uint8_t* buf,
+    size_t         len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (buf[i] != (uint8_t)i)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint64_t
+benchWrite(
+    OS_FileSystem_Handle_t hFs,
+    size_t                 chunk)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    uint64_t start, stop;
+
+    fillPattern(benchBuf, chunk);
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, benchFileName,
+                                        OS_FileSystem_OpenMode_WRONLY,
+                                        OS_FileSystem_OpenFlags_CREATE));
+
+    start = bench_getTimeNs();
+    for (off_t written = 0; written < benchFileSize; written += chunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, written, chunk,
+                                             benchBuf));
+    }
+    // Closing flushes whatever the FS still buffers, so it is part of the
+    // measurement
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    stop = bench_getTimeNs();
+
+    return stop - start;
+}
+
+static uint64_t
+benchRead(
+    OS_FileSystem_Handle_t hFs,
+    size_t                 chunk)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    uint64_t start, stop;
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, benchFileName,
+                                        OS_FileSystem_OpenMode_RDONLY,
+                                        OS_FileSystem_OpenFlags_NONE));
+
+    start = bench_getTimeNs();
+    for (off_t read = 0; read < benchFileSize; read += chunk)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_read(hFs, hFile, read, chunk,
+                                            benchBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    stop = bench_getTimeNs();
+
+    // Every chunk was written with the same pattern; we only check the last
+    // one as we are not testing correctness here but want to catch gross
+    // errors which would render the numbers meaningless
+    TEST_TRUE(checkPattern(benchBuf, chunk));
+
+    return stop - start;
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Write and read a file sequentially with a sweep of chunk sizes (from 8 bytes
+ * up to the size of the storage dataport) and print the throughput for each.
+ */
+void
+bench_OS_FileSystem_throughput(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+    size_t maxChunk;
+    uint64_t nsWrite, nsRead;
+    char name[32];
+
+    TEST_START("i", cfg->type);
+
+    maxChunk = OS_Dataport_getSize(cfg->storage.dataport);
+    if (maxChunk > sizeof(benchBuf))
+    {
+        maxChunk = sizeof(benchBuf);
+    }
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+
+    Debug_LOG_INFO("throughput %-8s | %6s | %12s | %12s",
+                   bench_getFsName(cfg->type), "chunk", "write KiB/s",
+                   "read KiB/s");
+
+    for (size_t chunk = benchMinChunk; chunk <= maxChunk; chunk *= 2)
+    {
+        // Report the storage traffic (incl. erases) caused by the write pass
+        DISK_STATS_RESET;
+        nsWrite = benchWrite(hFs, chunk);
+        bench_logDiskStats("seq write", cfg->type);
+        nsRead  = benchRead(hFs, chunk);
+
+        Debug_LOG_INFO("throughput %-8s | %6zu | %12" PRIu64 " | %12" PRIu64,
+                       bench_getFsName(cfg->type), chunk,
+                       bench_getKiBps(benchFileSize, nsWrite),
+                       bench_getKiBps(benchFileSize, nsRead));
+
+        snprintf(name, sizeof(name), "seq write %zu", chunk);
+        bench_logResult("metric", name, bench_getFsName(cfg->type),
+                        bench_getKiBps(benchFileSize, nsWrite), "KiB/s");
+        snprintf(name, sizeof(name), "seq read %zu", chunk);
+        bench_logResult("metric", name, bench_getFsName(cfg->type),
+                        bench_getKiBps(benchFileSize, nsRead), "KiB/s");
+
+        TEST_SUCCESS(OS_FileSystemFile_delete(hFs, benchFileName));
+    }
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    TEST_FINISH();
+}
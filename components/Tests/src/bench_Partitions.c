@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "BlockCache.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+/*
+ * Two FS of different types, each on its own partition of the same disk. The
+ * partition windows are set in the configuration of the disk and must match
+ * the offsets and sizes here.
+ */
+#define PART_SIZE       (512 * 1024)
+#define PART_COUNT      2
+
+static const off_t partOffsets[PART_COUNT] = { 0, PART_SIZE };
+
+static OS_FileSystem_Config_t partCfgs[PART_COUNT] =
+{
+    {
+        .type = OS_FileSystem_Type_LITTLEFS,
+        .size = OS_FileSystem_USE_STORAGE_MAX,
+        .format = &bench_littleFsFormat,
+        .storage = IF_OS_STORAGE_ASSIGN(
+            part0_rpc,
+            part0_port),
+    },
+    {
+        .type = OS_FileSystem_Type_FATFS,
+        .size = OS_FileSystem_USE_STORAGE_MAX,
+        .storage = IF_OS_STORAGE_ASSIGN(
+            part1_rpc,
+            part1_port),
+    },
+};
+
+// Both files are written in turns, one chunk at a time
+static const char* partFileName = "partfile.bin";
+static const off_t partFileSize = 64 * 1024;
+static const size_t partChunk   = 512;
+
+static uint8_t partBuf[512];
+
+// Private Functions -----------------------------------------------------------
+
+static uint64_t
+getPartDigest(
+    unsigned int part)
+{
+    uint64_t digest;
+
+    TEST_SUCCESS(disk_rpc_digest(partOffsets[part], PART_SIZE, &digest));
+
+    return digest;
+}
+
+static bool
+isChunk(
+    const uint8_t* buf,
+    unsigned int   part,
+    off_t          pos)
+{
+    for (size_t i = 0; i < partChunk; i++)
+    {
+        if (buf[i] != (uint8_t)(part + pos / partChunk))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Mount a LittleFS and a FAT on two partitions of the same disk at the same
+ * time, write a file to each of them with the writes interleaved, and read
+ * both back. Prints the combined throughput and checks that formatting one
+ * partition leaves the other one alone. This destroys any FS on the disk.
+ */
+void
+bench_Partitions_interleaved(void)
+{
+    OS_FileSystem_Handle_t hFs[PART_COUNT];
+    OS_FileSystemFile_Handle_t hFile[PART_COUNT];
+    uint64_t digest, start, nsWrite, nsRead;
+    off_t pos;
+
+    TEST_START();
+
+    for (unsigned int i = 0; i < PART_COUNT; i++)
+    {
+        TEST_SUCCESS(OS_FileSystem_init(&hFs[i], &partCfgs[i]));
+    }
+
+    // Formatting the second FS must not touch the first one
+    TEST_SUCCESS(OS_FileSystem_format(hFs[0]));
+    digest = getPartDigest(0);
+    TEST_SUCCESS(OS_FileSystem_format(hFs[1]));
+    TEST_TRUE(getPartDigest(0) == digest);
+
+    for (unsigned int i = 0; i < PART_COUNT; i++)
+    {
+        TEST_SUCCESS(OS_FileSystem_mount(hFs[i]));
+        TEST_SUCCESS(OS_FileSystemFile_open(hFs[i], &hFile[i], partFileName,
+                                            OS_FileSystem_OpenMode_RDWR,
+                                            OS_FileSystem_OpenFlags_CREATE));
+    }
+
+    start = bench_getTimeNs();
+    for (pos = 0; pos < partFileSize; pos += partChunk)
+    {
+        for (unsigned int i = 0; i < PART_COUNT; i++)
+        {
+            memset(partBuf, (int)(i + pos / partChunk), partChunk);
+            TEST_SUCCESS(OS_FileSystemFile_write(hFs[i], hFile[i], pos,
+                                                 partChunk, partBuf));
+        }
+    }
+    nsWrite = bench_getTimeNs() - start;
+
+    start = bench_getTimeNs();
+    for (pos = 0; pos < partFileSize; pos += partChunk)
+    {
+        for (unsigned int i = 0; i < PART_COUNT; i++)
+        {
+            TEST_SUCCESS(OS_FileSystemFile_read(hFs[i], hFile[i], pos,
+                                                partChunk, partBuf));
+            TEST_TRUE(isChunk(partBuf, i, pos));
+        }
+    }
+    nsRead = bench_getTimeNs() - start;
+
+    for (unsigned int i = 0; i < PART_COUNT; i++)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_close(hFs[i], hFile[i]));
+        TEST_SUCCESS(OS_FileSystem_unmount(hFs[i]));
+        TEST_SUCCESS(OS_FileSystem_free(hFs[i]));
+    }
+
+    Debug_LOG_INFO("partitions %s+%s | write %8" PRIu64 " KiB/s | "
+                   "read %8" PRIu64 " KiB/s",
+                   bench_getFsName(partCfgs[0].type),
+                   bench_getFsName(partCfgs[1].type),
+                   bench_getKiBps(PART_COUNT * partFileSize, nsWrite),
+                   bench_getKiBps(PART_COUNT * partFileSize, nsRead));
+
+    TEST_FINISH();
+}
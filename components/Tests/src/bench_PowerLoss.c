@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+/*
+ * Every trial starts on the same freshly formatted FS with a base file which
+ * is not touched afterwards; it is made once and put back from a snapshot of
+ * the disk before each trial. Then records are appended to a log file, each with its
+ * own open/write/close, so a record counts as committed once it is closed.
+ * The power fails after a random number of writes/erases of the disk, in the
+ * middle of one of them; the volume is then mounted again. The time of this
+ * mount is the recovery time, records committed but not found intact (in
+ * order from the start of the log) are lost. If all PL_MAX_RECORDS records
+ * get through before the power fails, the trial is skipped.
+ */
+static const char* plBaseName = "plbase.bin";
+static const char* plLogName  = "pllog.bin";
+static const size_t plBaseSize = 4096;
+
+#define PL_TRIALS       8
+#define PL_RECORD_SIZE  256
+#define PL_MAX_RECORDS  128
+// The cut hits one of the first PL_MAX_MODS writes/erases of the appends
+#define PL_MAX_MODS     256
+
+static uint8_t plBuf[PL_RECORD_SIZE];
+static uint8_t plExpected[PL_RECORD_SIZE];
+
+typedef struct
+{
+    uint64_t     mountNs;
+    uint64_t     maxMountNs;
+    unsigned int mounts;
+    unsigned int lost;
+    unsigned int failedMounts;
+    unsigned int brokenBase;
+    unsigned int uncut;
+} PlSummary_t;
+
+// Private Functions -----------------------------------------------------------
+
+static void
+fillRecord(
+    uint8_t*     buf,
+    unsigned int rec)
+{
+    for (size_t i = 0; i < PL_RECORD_SIZE; i++)
+    {
+        buf[i] = (uint8_t)(rec * 31 + i);
+    }
+}
+
+static OS_Error_t
+writeFile(
+    OS_FileSystem_Handle_t hFs,
+    const char*            name,
+    off_t                  offset,
+    unsigned int           rec)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    OS_Error_t err;
+
+    fillRecord(plBuf, rec);
+
+    if ((err = OS_FileSystemFile_open(hFs, &hFile, name,
+                                      OS_FileSystem_OpenMode_RDWR,
+                                      OS_FileSystem_OpenFlags_CREATE))
+        != OS_SUCCESS)
+    {
+        return err;
+    }
+    if ((err = OS_FileSystemFile_write(hFs, hFile, offset, PL_RECORD_SIZE,
+                                       plBuf)) != OS_SUCCESS)
+    {
+        OS_FileSystemFile_close(hFs, hFile);
+        return err;
+    }
+
+    return OS_FileSystemFile_close(hFs, hFile);
+}
+
+/*
+ * Count the records which are intact, starting from the first one of the
+ * file, and stop at the first which is not; the base file is made of records
+ * as well.
+ */
+static unsigned int
+countRecords(
+    OS_FileSystem_Handle_t hFs,
+    const char*            name)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    unsigned int rec = 0;
+    off_t size;
+
+    if ((OS_FileSystemFile_getSize(hFs, name, &size) != OS_SUCCESS)
+        || (OS_FileSystemFile_open(hFs, &hFile, name,
+                                   OS_FileSystem_OpenMode_RDONLY,
+                                   OS_FileSystem_OpenFlags_NONE)
+            != OS_SUCCESS))
+    {
+        return 0;
+    }
+
+    for (; ((off_t)(rec + 1) * PL_RECORD_SIZE) <= size; rec++)
+    {
+        fillRecord(plExpected, rec);
+        if ((OS_FileSystemFile_read(hFs, hFile, (off_t)rec * PL_RECORD_SIZE,
+                                    PL_RECORD_SIZE, plBuf) != OS_SUCCESS)
+            || memcmp(plBuf, plExpected, PL_RECORD_SIZE))
+        {
+            break;
+        }
+    }
+
+    OS_FileSystemFile_close(hFs, hFile);
+
+    return rec;
+}
+
+static void
+createBase(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    for (unsigned int rec = 0; rec < (plBaseSize / PL_RECORD_SIZE); rec++)
+    {
+        TEST_SUCCESS(writeFile(hFs, plBaseName, rec * PL_RECORD_SIZE, rec));
+    }
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+}
+
+static void
+runTrial(
+    OS_FileSystem_Config_t* cfg,
+    unsigned int            trial,
+    uint32_t*               rnd,
+    PlSummary_t*            sum)
+{
+    OS_FileSystem_Handle_t hFs;
+    unsigned int const mods = bench_getRandom(rnd) % PL_MAX_MODS;
+    unsigned int committed = 0, recovered, base;
+    uint64_t start, cleanNs, mountNs;
+    size_t blocks;
+    OS_Error_t err;
+
+    TEST_SUCCESS(disk_rpc_restore(&blocks));
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    cleanNs = bench_getTimeNs() - start;
+
+    TEST_SUCCESS(DISK_POWER_CUT(mods, -1));
+    while ((committed < PL_MAX_RECORDS)
+           && (writeFile(hFs, plLogName, committed * PL_RECORD_SIZE,
+                         committed) == OS_SUCCESS))
+    {
+        committed++;
+    }
+
+    if (committed == PL_MAX_RECORDS)
+    {
+        // The cut did not fire; disarm it, a clean remount is no recovery
+        TEST_SUCCESS(DISK_POWER_ON);
+        TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+        TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+        Debug_LOG_INFO("powerloss %-8s | trial %u | cut after %3u mods | "
+                       "not cut within %u records, skipped",
+                       bench_getFsName(cfg->type), trial, mods,
+                       PL_MAX_RECORDS);
+        sum->uncut++;
+        return;
+    }
+
+    // Like after a removal, this must not touch the disk
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+    TEST_SUCCESS(DISK_POWER_ON);
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+
+    start = bench_getTimeNs();
+    err = OS_FileSystem_mount(hFs);
+    mountNs = bench_getTimeNs() - start;
+
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_INFO("powerloss %-8s | trial %u | cut after %3u mods | "
+                       "mount failed, code %d",
+                       bench_getFsName(cfg->type), trial, mods, err);
+        sum->failedMounts++;
+        sum->lost += committed;
+        TEST_SUCCESS(OS_FileSystem_free(hFs));
+        return;
+    }
+
+    recovered = countRecords(hFs, plLogName);
+    base      = countRecords(hFs, plBaseName);
+
+    // The record in flight may or may not have made it
+    if (recovered < committed)
+    {
+        sum->lost += committed - recovered;
+    }
+    if (base != (plBaseSize / PL_RECORD_SIZE))
+    {
+        sum->brokenBase++;
+    }
+    sum->mountNs += mountNs;
+    sum->mounts++;
+    if (mountNs > sum->maxMountNs)
+    {
+        sum->maxMountNs = mountNs;
+    }
+
+    Debug_LOG_INFO("powerloss %-8s | trial %u | cut after %3u mods | "
+                   "mount %9" PRIu64 " ns (clean %9" PRIu64 " ns) | "
+                   "committed %3u | recovered %3u | base %s",
+                   bench_getFsName(cfg->type), trial, mods, mountNs, cleanNs,
+                   committed, recovered,
+                   (base == (plBaseSize / PL_RECORD_SIZE)) ? "ok" : "BROKEN");
+
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Cut the power in the middle of a write while a log file is appended to,
+ * then print how long mounting the volume takes and how many committed
+ * records are lost. This is repeated with cuts at different points; it needs
+ * the cache in bypass mode, so nothing committed is held back in it.
+ */
+void
+bench_PowerLoss_recovery(
+    OS_FileSystem_Config_t* cfg)
+{
+    PlSummary_t sum;
+    uint32_t rnd = bench_RANDOM_SEED;
+    uint64_t avgNs;
+
+    TEST_START("i", cfg->type);
+
+    memset(&sum, 0, sizeof(sum));
+
+    createBase(cfg);
+    TEST_SUCCESS(disk_rpc_snapshot());
+
+    for (unsigned int trial = 0; trial < PL_TRIALS; trial++)
+    {
+        runTrial(cfg, trial, &rnd, &sum);
+    }
+
+    avgNs = (sum.mounts > 0) ? sum.mountNs / sum.mounts : 0;
+
+    Debug_LOG_INFO("powerloss %-8s | recovery mount avg %9" PRIu64 " ns, "
+                   "max %9" PRIu64 " ns | lost %u records | %u failed mounts "
+                   "| %u broken base files | %u trials not cut",
+                   bench_getFsName(cfg->type), avgNs, sum.maxMountNs,
+                   sum.lost, sum.failedMounts, sum.brokenBase, sum.uncut);
+
+    TEST_FINISH();
+}
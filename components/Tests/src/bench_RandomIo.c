@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Every access pattern is run with every I/O size on a file of rioFileSize,
+ * first with rioOps writes and then with rioOps reads. I/Os are aligned to
+ * their size; the content of each byte only depends on its position, so every
+ * read can be checked no matter what was written before.
+ */
+static const char* rioFileName = "randio.bin";
+static const off_t rioFileSize = 256 * 1024;
+// Must be powers of two and not exceed the dataport size
+static const size_t rioSizes[] = { 64, 512, 4096 };
+
+#define RIO_OPS         256
+// Distance between two strided I/Os, in I/Os
+#define RIO_STRIDE      7
+// Hot-spot accesses pick a block by a Zipf distribution with exponent 1
+#define RIO_MAX_BLOCKS  4096
+
+typedef enum
+{
+    RIO_PATTERN_RANDOM,
+    RIO_PATTERN_STRIDED,
+    RIO_PATTERN_HOTSPOT,
+    RIO_PATTERN_NUM
+} RioPattern_t;
+
+static const char* rioPatternNames[RIO_PATTERN_NUM] =
+{
+    "random", "strided", "hotspot"
+};
+
+static uint8_t rioBuf[4096];
+static uint8_t rioExpected[4096];
+static uint64_t rioLatency[RIO_OPS];
+// Cumulative Zipf weights of the blocks by rank
+static uint32_t rioZipf[RIO_MAX_BLOCKS];
+
+// Private Functions -----------------------------------------------------------
+
+static void
+initZipf(
+    unsigned int blocks)
+{
+    uint32_t sum = 0;
+
+    for (unsigned int k = 0; k < blocks; k++)
+    {
+        sum += (1U << 20) / (k + 1);
+        rioZipf[k] = sum;
+    }
+}
+
+static unsigned int
+getZipfRank(
+    unsigned int blocks,
+    uint32_t     rnd)
+{
+    uint32_t const val = rnd % rioZipf[blocks - 1];
+    unsigned int lo = 0, hi = blocks - 1;
+
+    while (lo < hi)
+    {
+        unsigned int const mid = (lo + hi) / 2;
+
+        if (rioZipf[mid] > val)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+
+    return lo;
+}
+
+static off_t
+getOffset(
+    RioPattern_t pattern,
+    size_t       ioSize,
+    unsigned int op,
+    uint32_t*    rnd)
+{
+    unsigned int const blocks = rioFileSize / ioSize;
+    unsigned int block;
+
+    switch (pattern)
+    {
+    case RIO_PATTERN_STRIDED:
+        block = (op * RIO_STRIDE) % blocks;
+        break;
+    case RIO_PATTERN_HOTSPOT:
+        // Scatter the ranks over the file; an odd factor keeps them unique,
+        // as the number of blocks is a power of two
+        block = (getZipfRank(blocks, bench_getRandom(rnd)) * 2654435761U)
+                % blocks;
+        break;
+    default:
+        block = bench_getRandom(rnd) % blocks;
+        break;
+    }
+
+    return (off_t)block * ioSize;
+}
+
+static int
+compareNs(
+    const void* a,
+    const void* b)
+{
+    uint64_t const x = *(const uint64_t*)a;
+    uint64_t const y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static void
+createFile(
+    OS_FileSystem_Handle_t hFs)
+{
+    OS_FileSystemFile_Handle_t hFile;
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, rioFileName,
+                                        OS_FileSystem_OpenMode_WRONLY,
+                                        OS_FileSystem_OpenFlags_CREATE));
+    for (off_t pos = 0; pos < rioFileSize; pos += sizeof(rioBuf))
+    {
+        bench_fillPattern(rioBuf, 0, pos, sizeof(rioBuf));
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, pos, sizeof(rioBuf),
+                                             rioBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+}
+
+static void
+runPattern(
+    OS_FileSystem_Handle_t hFs,
+    OS_FileSystem_Type_t   type,
+    RioPattern_t           pattern,
+    size_t                 ioSize,
+    bool                   isWrite)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    uint32_t rnd = bench_RANDOM_SEED;
+    uint64_t start, ns = 0, iops;
+    char name[32];
+    off_t pos;
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, rioFileName,
+                                        OS_FileSystem_OpenMode_RDWR,
+                                        OS_FileSystem_OpenFlags_NONE));
+
+    for (unsigned int op = 0; op < RIO_OPS; op++)
+    {
+        pos = getOffset(pattern, ioSize, op, &rnd);
+
+        if (isWrite)
+        {
+            bench_fillPattern(rioBuf, 0, pos, ioSize);
+            start = bench_getTimeNs();
+            TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, pos, ioSize,
+                                                 rioBuf));
+            rioLatency[op] = bench_getTimeNs() - start;
+        }
+        else
+        {
+            start = bench_getTimeNs();
+            TEST_SUCCESS(OS_FileSystemFile_read(hFs, hFile, pos, ioSize,
+                                                rioBuf));
+            rioLatency[op] = bench_getTimeNs() - start;
+
+            bench_fillPattern(rioExpected, 0, pos, ioSize);
+            TEST_TRUE(!memcmp(rioBuf, rioExpected, ioSize));
+        }
+        ns += rioLatency[op];
+    }
+
+    // Whatever the FS still buffers is written back here, it is not counted
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+
+    qsort(rioLatency, RIO_OPS, sizeof(rioLatency[0]), compareNs);
+    iops = (ns > 0) ? (RIO_OPS * 1000000000ULL) / ns : 0;
+
+    Debug_LOG_INFO("randio %-8s %-7s %-5s | %4zu B | %7" PRIu64 " IOPS | "
+                   "p50 %9" PRIu64 " | p90 %9" PRIu64 " | p99 %9" PRIu64
+                   " | max %9" PRIu64 " ns",
+                   bench_getFsName(type), rioPatternNames[pattern],
+                   isWrite ? "write" : "read", ioSize,
+                   iops,
+                   rioLatency[(RIO_OPS * 50) / 100],
+                   rioLatency[(RIO_OPS * 90) / 100],
+                   rioLatency[(RIO_OPS * 99) / 100],
+                   rioLatency[RIO_OPS - 1]);
+
+    snprintf(name, sizeof(name), "%s %s %zu", rioPatternNames[pattern],
+             isWrite ? "write" : "read", ioSize);
+    bench_logResult("metric", name, bench_getFsName(type), iops, "IOPS");
+    bench_logResult("metric", name, bench_getFsName(type),
+                    rioLatency[(RIO_OPS * 99) / 100], "ns");
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Print IOPS and latency percentiles of reads and writes at random, strided
+ * and hot-spot offsets within a large file, for each of the I/O sizes. The
+ * file is created on a freshly formatted FS before the first run.
+ */
+void
+bench_RandomIo_patterns(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+
+    TEST_START("i", cfg->type);
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+
+    createFile(hFs);
+
+    for (size_t i = 0; i < sizeof(rioSizes) / sizeof(rioSizes[0]); i++)
+    {
+        TEST_TRUE(rioSizes[i] <= sizeof(rioBuf));
+        TEST_TRUE((rioFileSize / rioSizes[i]) <= RIO_MAX_BLOCKS);
+
+        initZipf(rioFileSize / rioSizes[i]);
+
+        for (RioPattern_t p = 0; p < RIO_PATTERN_NUM; p++)
+        {
+            runPattern(hFs, cfg->type, p, rioSizes[i], true);
+            runPattern(hFs, cfg->type, p, rioSizes[i], false);
+        }
+    }
+
+    TEST_SUCCESS(OS_FileSystemFile_delete(hFs, rioFileName));
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    TEST_FINISH();
+}
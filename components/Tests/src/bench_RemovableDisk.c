@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_Dataport.h"
+
+#include "lib_macros/Test.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+/*
+ * The small-file workload models what a FAT-like FS does when a small file is
+ * appended to: it writes a data cluster, updates the allocation table entry
+ * in both table copies and rewrites the directory entry. These are four small
+ * scattered I/Os for each file.
+ */
+#define SMALL_FILES         64
+#define EXTENTS_PER_FILE    4
+
+static const RemovableDisk_Extent_t fileLayout[EXTENTS_PER_FILE] =
+{
+    { .offset = 8   * 1024, .size = 32  },  // directory entry
+    { .offset = 16  * 1024, .size = 4   },  // table entry, 1st copy
+    { .offset = 32  * 1024, .size = 4   },  // table entry, 2nd copy
+    { .offset = 512 * 1024, .size = 512 },  // data cluster
+};
+// Stride between the extents of two consecutive files
+static const off_t fileStride[EXTENTS_PER_FILE] = { 32, 4, 4, 4096 };
+
+static const OS_Dataport_t port = OS_DATAPORT_ASSIGN(disk_port);
+
+/*
+ * The queue depth sweep moves ASYNC_REQUESTS blocks of the slot size through
+ * the async rings, cycling through a region of ASYNC_BLOCKS blocks. Every
+ * block is filled with its own index, so reads can be checked.
+ */
+#define ASYNC_REQUESTS  512
+#define ASYNC_BLOCKS    128
+#define ASYNC_BASE      (512 * 1024)
+
+static const OS_Dataport_t asyncPort     = OS_DATAPORT_ASSIGN(async_port);
+static const OS_Dataport_t asyncDataPort =
+    OS_DATAPORT_ASSIGN_SIZE(async_data_port, RemovableDisk_ASYNC_DATA_SIZE);
+
+// Private Functions -----------------------------------------------------------
+
+static void
+getFileExtents(
+    unsigned int            file,
+    RemovableDisk_Extent_t* extents)
+{
+    for (unsigned int i = 0; i < EXTENTS_PER_FILE; i++)
+    {
+        extents[i].offset = fileLayout[i].offset + file * fileStride[i];
+        extents[i].size   = fileLayout[i].size;
+    }
+}
+
+static void
+fillExtents(
+    uint8_t*                      buf,
+    const RemovableDisk_Extent_t* extents,
+    unsigned int                  file)
+{
+    for (unsigned int i = 0; i < EXTENTS_PER_FILE; i++)
+    {
+        memset(buf, (int)(file + i), extents[i].size);
+        buf += extents[i].size;
+    }
+}
+
+/*
+ * A vectored call with a single extent is exactly what a plain storage write
+ * is; we use it as baseline so both variants take the same path to the disk.
+ */
+static uint64_t
+writeSingle(void)
+{
+    RemovableDisk_Extent_t extents[EXTENTS_PER_FILE];
+    RemovableDisk_Extent_t* ext = OS_Dataport_getBuf(port);
+    uint8_t* data = RemovableDisk_EXTENTS_DATA(ext, 1);
+    uint64_t start;
+    size_t written;
+
+    start = bench_getTimeNs();
+    for (unsigned int file = 0; file < SMALL_FILES; file++)
+    {
+        getFileExtents(file, extents);
+        for (unsigned int i = 0; i < EXTENTS_PER_FILE; i++)
+        {
+            *ext = extents[i];
+            memset(data, (int)(file + i), extents[i].size);
+            TEST_SUCCESS(disk_rpc_writev(1, &written));
+        }
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+static uint64_t
+writeVectored(void)
+{
+    RemovableDisk_Extent_t* extents = OS_Dataport_getBuf(port);
+    uint8_t* data = RemovableDisk_EXTENTS_DATA(extents, EXTENTS_PER_FILE);
+    uint64_t start;
+    size_t written;
+
+    start = bench_getTimeNs();
+    for (unsigned int file = 0; file < SMALL_FILES; file++)
+    {
+        getFileExtents(file, extents);
+        fillExtents(data, extents, file);
+        TEST_SUCCESS(disk_rpc_writev(EXTENTS_PER_FILE, &written));
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+static uint64_t
+readSingle(void)
+{
+    RemovableDisk_Extent_t extents[EXTENTS_PER_FILE];
+    RemovableDisk_Extent_t* ext = OS_Dataport_getBuf(port);
+    uint64_t start;
+    size_t read;
+
+    start = bench_getTimeNs();
+    for (unsigned int file = 0; file < SMALL_FILES; file++)
+    {
+        getFileExtents(file, extents);
+        for (unsigned int i = 0; i < EXTENTS_PER_FILE; i++)
+        {
+            *ext = extents[i];
+            TEST_SUCCESS(disk_rpc_readv(1, &read));
+        }
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+static uint64_t
+readVectored(void)
+{
+    static uint8_t expected[4096];
+    RemovableDisk_Extent_t* extents = OS_Dataport_getBuf(port);
+    uint8_t* data = RemovableDisk_EXTENTS_DATA(extents, EXTENTS_PER_FILE);
+    uint64_t start, ns = 0;
+    size_t read;
+
+    for (unsigned int file = 0; file < SMALL_FILES; file++)
+    {
+        getFileExtents(file, extents);
+        start = bench_getTimeNs();
+        TEST_SUCCESS(disk_rpc_readv(EXTENTS_PER_FILE, &read));
+        ns += bench_getTimeNs() - start;
+
+        // Make sure the vectored calls really moved the right data
+        fillExtents(expected, extents, file);
+        TEST_TRUE(!memcmp(expected, data, read));
+    }
+
+    return ns;
+}
+
+static void
+logResult(
+    const char* label,
+    uint64_t    ns)
+{
+    static RemovableDisk_Stats_t stats;
+
+    TEST_SUCCESS(RemovableDisk_getStats(&stats));
+    DISK_STATS_RESET;
+
+    Debug_LOG_INFO("vectored %-12s | %4" PRIu64 " round-trips | "
+                   "%8" PRIu64 " ns/file",
+                   label,
+                   stats.ops[RemovableDisk_Op_READ].calls
+                   + stats.ops[RemovableDisk_Op_WRITE].calls,
+                   ns / SMALL_FILES);
+}
+
+static void
+asyncSubmit(
+    RemovableDisk_AsyncRings_t* rings,
+    RemovableDisk_Op_t          op,
+    uint32_t                    slot,
+    unsigned int                idx)
+{
+    uint32_t const tail = rings->sqTail;
+    RemovableDisk_AsyncRequest_t* const req =
+        &rings->sq[tail % RemovableDisk_ASYNC_DEPTH];
+    unsigned int const block = idx % ASYNC_BLOCKS;
+
+    req->tag    = idx;
+    req->op     = op;
+    req->slot   = slot;
+    req->offset = ASYNC_BASE + (off_t)block * RemovableDisk_ASYNC_SLOT_SIZE;
+    req->size   = RemovableDisk_ASYNC_SLOT_SIZE;
+
+    __atomic_store_n(&rings->sqTail, tail + 1, __ATOMIC_RELEASE);
+    async_submit_emit();
+}
+
+static void
+asyncReap(
+    RemovableDisk_AsyncRings_t*      rings,
+    RemovableDisk_AsyncCompletion_t* cpl)
+{
+    uint32_t const head = rings->cqHead;
+
+    // If the disk signals between our check and the wait, the notification
+    // stays pending and the wait returns right away
+    while (head == __atomic_load_n(&rings->cqTail, __ATOMIC_ACQUIRE))
+    {
+        async_complete_wait();
+    }
+
+    *cpl = rings->cq[head % RemovableDisk_ASYNC_DEPTH];
+    __atomic_store_n(&rings->cqHead, head + 1, __ATOMIC_RELEASE);
+}
+
+static bool
+isFilled(
+    const uint8_t* buf,
+    uint8_t        val)
+{
+    for (size_t i = 0; i < RemovableDisk_ASYNC_SLOT_SIZE; i++)
+    {
+        if (buf[i] != val)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Keep depth requests in flight until ASYNC_REQUESTS are done. Request i uses
+ * slot (i % depth); its completion frees the slot for request (i + depth).
+ */
+static uint64_t
+asyncRun(
+    RemovableDisk_Op_t op,
+    unsigned int       depth)
+{
+    RemovableDisk_AsyncRings_t* const rings = OS_Dataport_getBuf(asyncPort);
+    uint8_t* const data = OS_Dataport_getBuf(asyncDataPort);
+    RemovableDisk_AsyncCompletion_t cpl;
+    unsigned int issued, done;
+    uint64_t start;
+    uint8_t* buf;
+
+    start = bench_getTimeNs();
+
+    for (issued = 0; issued < depth; issued++)
+    {
+        buf = RemovableDisk_ASYNC_SLOT(data, issued);
+        if (op == RemovableDisk_Op_WRITE)
+        {
+            memset(buf, issued % ASYNC_BLOCKS, RemovableDisk_ASYNC_SLOT_SIZE);
+        }
+        asyncSubmit(rings, op, issued, issued);
+    }
+
+    for (done = 0; done < ASYNC_REQUESTS; done++)
+    {
+        asyncReap(rings, &cpl);
+        TEST_SUCCESS(cpl.err);
+        TEST_TRUE(cpl.size == RemovableDisk_ASYNC_SLOT_SIZE);
+
+        uint32_t const slot = cpl.tag % depth;
+        buf = RemovableDisk_ASYNC_SLOT(data, slot);
+
+        // Checking the data overlaps with the disk serving the other requests
+        if (op == RemovableDisk_Op_READ)
+        {
+            TEST_TRUE(isFilled(buf, cpl.tag % ASYNC_BLOCKS));
+        }
+
+        if (issued < ASYNC_REQUESTS)
+        {
+            if (op == RemovableDisk_Op_WRITE)
+            {
+                memset(buf, issued % ASYNC_BLOCKS,
+                       RemovableDisk_ASYNC_SLOT_SIZE);
+            }
+            asyncSubmit(rings, op, slot, issued);
+            issued++;
+        }
+    }
+
+    return bench_getTimeNs() - start;
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Compare the cost of a small-file workload done with one storage RPC per
+ * extent against one vectored RPC per file. This works on the raw disk and
+ * destroys any FS on it.
+ */
+void
+bench_RemovableDisk_vectored(void)
+{
+    uint64_t ns;
+
+    TEST_START();
+
+    DISK_STATS_RESET;
+
+    ns = writeSingle();
+    logResult("write single", ns);
+    ns = writeVectored();
+    logResult("write vector", ns);
+    ns = readSingle();
+    logResult("read single", ns);
+    ns = readVectored();
+    logResult("read vector", ns);
+
+    TEST_FINISH();
+}
+
+/**
+ * Move blocks through the asynchronous rings of the disk with an increasing
+ * number of requests in flight and print IOPS and throughput for each queue
+ * depth. This works on the raw disk and destroys any FS on it.
+ */
+void
+bench_RemovableDisk_queueDepth(void)
+{
+    static const RemovableDisk_Op_t ops[] =
+    {
+        RemovableDisk_Op_WRITE, RemovableDisk_Op_READ
+    };
+    uint64_t ns, iops;
+
+    TEST_START();
+
+    Debug_LOG_INFO("async %-5s | %5s | %8s | %10s", "op", "depth", "IOPS",
+                   "KiB/s");
+
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+        for (unsigned int depth = 1; depth <= RemovableDisk_ASYNC_DEPTH;
+             depth *= 2)
+        {
+            ns   = asyncRun(ops[i], depth);
+            iops = (ns > 0) ? (ASYNC_REQUESTS * 1000000000ULL) / ns : 0;
+
+            Debug_LOG_INFO(
+                "async %-5s | %5u | %8" PRIu64 " | %10" PRIu64,
+                (ops[i] == RemovableDisk_Op_WRITE) ? "write" : "read",
+                depth,
+                iops,
+                bench_getKiBps(
+                    (uint64_t)ASYNC_REQUESTS * RemovableDisk_ASYNC_SLOT_SIZE,
+                    ns));
+        }
+    }
+
+    TEST_FINISH();
+}
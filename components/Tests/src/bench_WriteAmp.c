@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_FileSystem.h"
+
+#include "lib_macros/Test.h"
+#include "BlockCache.h"
+#include "RemovableDisk.h"
+#include "bench.h"
+#include "bench_stats.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Three workloads with different write patterns, each on a freshly formatted
+ * FS: appending to a log file, overwriting records in place within an
+ * existing file, and creating many small files.
+ */
+static const char* waFileName    = "wafile.bin";
+static const off_t waFileSize    = 64 * 1024;
+static const unsigned int waOverwrites = 256;
+static const unsigned int waSmallFiles = 32;
+static const size_t waSmallSize  = 128;
+
+// Size of a record; waBuf is the data of every write, also of a small file
+#define WA_CHUNK    256
+
+static uint8_t waBuf[WA_CHUNK];
+
+// Private Functions -----------------------------------------------------------
+
+static uint64_t
+appendFile(
+    OS_FileSystem_Handle_t hFs)
+{
+    OS_FileSystemFile_Handle_t hFile;
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, waFileName,
+                                        OS_FileSystem_OpenMode_WRONLY,
+                                        OS_FileSystem_OpenFlags_CREATE));
+    for (off_t pos = 0; pos < waFileSize; pos += WA_CHUNK)
+    {
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, pos, WA_CHUNK, waBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+
+    return waFileSize;
+}
+
+static uint64_t
+overwriteFile(
+    OS_FileSystem_Handle_t hFs)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    uint32_t seed = 1;
+
+    TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, waFileName,
+                                        OS_FileSystem_OpenMode_RDWR,
+                                        OS_FileSystem_OpenFlags_NONE));
+    for (unsigned int i = 0; i < waOverwrites; i++)
+    {
+        // Scatter the records over the file, the same way on every run
+        seed = seed * 1103515245 + 12345;
+        off_t const pos = ((seed >> 16) % (waFileSize / WA_CHUNK)) * WA_CHUNK;
+
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, pos, WA_CHUNK, waBuf));
+    }
+    TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+
+    return (uint64_t)waOverwrites * WA_CHUNK;
+}
+
+static uint64_t
+writeSmallFiles(
+    OS_FileSystem_Handle_t hFs)
+{
+    OS_FileSystemFile_Handle_t hFile;
+    char name[16];
+
+    for (unsigned int i = 0; i < waSmallFiles; i++)
+    {
+        snprintf(name, sizeof(name), "small%02u.bin", i);
+        TEST_SUCCESS(OS_FileSystemFile_open(hFs, &hFile, name,
+                                            OS_FileSystem_OpenMode_WRONLY,
+                                            OS_FileSystem_OpenFlags_CREATE));
+        TEST_SUCCESS(OS_FileSystemFile_write(hFs, hFile, 0, waSmallSize,
+                                             waBuf));
+        TEST_SUCCESS(OS_FileSystemFile_close(hFs, hFile));
+    }
+
+    return (uint64_t)waSmallFiles * waSmallSize;
+}
+
+// Public Functions ------------------------------------------------------------
+
+/**
+ * Print the write amplification (bytes written and erased on the disk per
+ * byte written by the application) of a FS for an append, an overwrite and a
+ * small-files workload. Formatting and mounting are not counted.
+ *
+ * The append runs on a freshly formatted FS; a snapshot of the result is the
+ * starting point of the other workloads, so they do not need to format again.
+ */
+void
+bench_WriteAmp_workloads(
+    OS_FileSystem_Config_t* cfg)
+{
+    OS_FileSystem_Handle_t hFs;
+    uint64_t bytes, start, nsFormat, nsRestore;
+    size_t blocks;
+
+    TEST_START("i", cfg->type);
+
+    memset(waBuf, 0x5A, sizeof(waBuf));
+
+    TEST_SUCCESS(OS_FileSystem_init(&hFs, cfg));
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(OS_FileSystem_format(hFs));
+    nsFormat = bench_getTimeNs() - start;
+
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    bench_startWriteAmp();
+    bytes = appendFile(hFs);
+    bench_logWriteAmp("append", cfg->type, bytes);
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+
+    /*
+     * The snapshot must cover the whole volume. In bypass mode the cache holds
+     * nothing back and the flush does nothing; it is there in case the cache
+     * was left in write-back mode.
+     */
+    TEST_SUCCESS(CACHE_FLUSH);
+    TEST_SUCCESS(disk_rpc_snapshot());
+
+    // Only now the file exists in full, so overwriting it grows nothing
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    bench_startWriteAmp();
+    bytes = overwriteFile(hFs);
+    bench_logWriteAmp("overwrite", cfg->type, bytes);
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+    TEST_SUCCESS(disk_rpc_restore(&blocks));
+
+    TEST_SUCCESS(OS_FileSystem_mount(hFs));
+    bench_startWriteAmp();
+    bytes = writeSmallFiles(hFs);
+    bench_logWriteAmp("small files", cfg->type, bytes);
+    TEST_SUCCESS(OS_FileSystem_unmount(hFs));
+
+    start = bench_getTimeNs();
+    TEST_SUCCESS(disk_rpc_restore(&blocks));
+    nsRestore = bench_getTimeNs() - start;
+
+    Debug_LOG_INFO("snapshot %-8s | format %10" PRIu64 " ns | restore %10"
+                   PRIu64 " ns (%zu blocks)",
+                   bench_getFsName(cfg->type), nsFormat, nsRestore, blocks);
+
+    TEST_SUCCESS(OS_FileSystem_free(hFs));
+
+    TEST_FINISH();
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "bench_stats.h"
+#include "bench.h"
+
+#include "BlockCache.h"
+#include "RemovableDisk.h"
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+// Bytes the disk has written/erased since bench_startWriteAmp()
+static uint64_t diskWritten;
+static uint64_t diskErased;
+
+// Private Functions -----------------------------------------------------------
+
+static OS_Error_t
+getDiskStats(
+    RemovableDisk_Stats_t* stats)
+{
+    OS_Error_t err;
+
+    if ((err = RemovableDisk_getStats(stats)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("RemovableDisk_getStats() failed, code %d", err);
+        return err;
+    }
+
+    diskWritten += stats->ops[RemovableDisk_Op_WRITE].bytes;
+    diskErased  += stats->ops[RemovableDisk_Op_ERASE].bytes;
+
+    return OS_SUCCESS;
+}
+
+// Public Functions ------------------------------------------------------------
+
+void
+bench_logDiskStats(
+    const char*          label,
+    OS_FileSystem_Type_t type)
+{
+    static RemovableDisk_Stats_t stats;
+
+    if (getDiskStats(&stats) != OS_SUCCESS)
+    {
+        return;
+    }
+
+    Debug_LOG_INFO(
+        "diskstats %-8s %-12s | rd %" PRIu64 " (%" PRIu64 " B) | "
+        "wr %" PRIu64 " (%" PRIu64 " B) | er %" PRIu64 " (%" PRIu64 " B) | "
+        "sz %" PRIu64 " | mem %" PRIu64 " B",
+        bench_getFsName(type), label,
+        stats.ops[RemovableDisk_Op_READ].calls,
+        stats.ops[RemovableDisk_Op_READ].bytes,
+        stats.ops[RemovableDisk_Op_WRITE].calls,
+        stats.ops[RemovableDisk_Op_WRITE].bytes,
+        stats.ops[RemovableDisk_Op_ERASE].calls,
+        stats.ops[RemovableDisk_Op_ERASE].bytes,
+        stats.ops[RemovableDisk_Op_GET_SIZE].calls,
+        stats.allocated);
+
+    DISK_STATS_RESET;
+}
+
+void
+bench_logDirty(
+    const char*          label,
+    OS_FileSystem_Type_t type)
+{
+    static const OS_Dataport_t port = OS_DATAPORT_ASSIGN(disk_port);
+    // Ranges we print in full, the rest is only counted
+    static const unsigned int maxRanges = 4;
+    const RemovableDisk_DirtyMap_t* map = OS_Dataport_getBuf(port);
+    char ranges[192];
+    size_t len = 0, size;
+    unsigned int dirty = 0, count = 0;
+    OS_Error_t err;
+
+    if (((err = CACHE_FLUSH) != OS_SUCCESS)
+        || ((err = disk_rpc_getDirty(&size)) != OS_SUCCESS))
+    {
+        Debug_LOG_ERROR("Getting dirty map failed, code %d", err);
+        return;
+    }
+
+    ranges[0] = '\0';
+    for (uint32_t blk = 0; blk < map->blocks; blk++)
+    {
+        uint32_t first = blk;
+
+        if (!RemovableDisk_IS_DIRTY(map, blk))
+        {
+            continue;
+        }
+        while (((blk + 1) < map->blocks)
+               && RemovableDisk_IS_DIRTY(map, blk + 1))
+        {
+            blk++;
+        }
+
+        dirty += blk - first + 1;
+        if (count++ < maxRanges)
+        {
+            len += snprintf(&ranges[len], sizeof(ranges) - len,
+                            " %#" PRIx64 "+%#" PRIx64,
+                            (uint64_t)first * map->blockSize,
+                            (uint64_t)(blk - first + 1) * map->blockSize);
+        }
+    }
+
+    Debug_LOG_INFO("dirty %-8s %-12s | gen %8" PRIu64 " | %5u blocks of %u B "
+                   "in %4u ranges:%s%s",
+                   bench_getFsName(type), label, map->generation, dirty,
+                   map->blockSize, count, ranges,
+                   (count > maxRanges) ? " ..." : "");
+
+    DISK_DIRTY_RESET;
+}
+
+void
+bench_startWriteAmp(
+    void)
+{
+    DISK_STATS_RESET;
+    diskWritten = 0;
+    diskErased  = 0;
+}
+
+void
+bench_logWriteAmp(
+    const char*          label,
+    OS_FileSystem_Type_t type,
+    uint64_t             appBytes)
+{
+    static RemovableDisk_Stats_t stats;
+    uint64_t factor;
+    OS_Error_t err;
+
+    if ((err = CACHE_FLUSH) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("cache_rpc_flush() failed, code %d", err);
+        return;
+    }
+    if (getDiskStats(&stats) != OS_SUCCESS)
+    {
+        return;
+    }
+    DISK_STATS_RESET;
+
+    // Report the factor with two decimals
+    factor = (appBytes > 0) ?
+             ((diskWritten + diskErased) * 100) / appBytes : 0;
+
+    Debug_LOG_INFO(
+        "writeamp %-8s %-12s | app %8" PRIu64 " B | wr %9" PRIu64 " B | "
+        "er %9" PRIu64 " B | factor %4" PRIu64 ".%02" PRIu64,
+        bench_getFsName(type), label,
+        appBytes, diskWritten, diskErased,
+        factor / 100, factor % 100);
+}
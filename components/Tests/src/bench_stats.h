@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_FileSystem.h"
+
+#include <stdint.h>
+
+/*
+ * Helpers which look at the disk and the block cache; unlike those in bench.h
+ * they need the disk and cache interfaces of the test component.
+ */
+
+/**
+ * Log how many storage calls (and bytes) the disk has seen since the last
+ * reset of its statistics, prefixed by a label naming the measured operation.
+ * The disk statistics are reset afterwards, so consecutive calls each report
+ * the cost of the operation in between.
+ */
+void
+bench_logDiskStats(
+    const char*          label,
+    OS_FileSystem_Type_t type);
+
+/**
+ * Log which regions of the disk were modified since the dirty map was last
+ * reset, prefixed by a label naming the operation; the map is reset
+ * afterwards. The block cache is flushed first.
+ */
+void
+bench_logDirty(
+    const char*          label,
+    OS_FileSystem_Type_t type);
+
+/**
+ * Start measuring the write amplification: from now on, the bytes written and
+ * erased on the disk are summed up (also across bench_logDiskStats() calls).
+ */
+void
+bench_startWriteAmp(
+    void);
+
+/**
+ * Log the bytes written and erased on the disk since bench_startWriteAmp() in
+ * relation to the given number of bytes the application wrote to the FS.
+ * The block cache is flushed first, so everything the FS wrote is counted.
+ */
+void
+bench_logWriteAmp(
+    const char*          label,
+    OS_FileSystem_Type_t type,
+    uint64_t             appBytes);
@@ -7,10 +7,12 @@
  */
 
 #include "OS_FileSystem.h"
-#include "OS_Crypto.h"
 
 #include "lib_macros/Test.h"
+#include "BlockCache.h"
 #include "RemovableDisk.h"
+#include "bench.h"
+#include "bench_stats.h"
 
 #include <camkes.h>
 
@@ -22,23 +24,36 @@ void test_OS_FileSystemFile(
 void test_OS_FileSystemFile_removal(
     OS_FileSystem_Handle_t hFs,
     OS_FileSystem_Type_t type);
+void bench_OS_FileSystem_throughput(
+    OS_FileSystem_Config_t* cfg);
+void bench_RemovableDisk_vectored(void);
+void bench_RemovableDisk_queueDepth(void);
+void bench_BlockCache_smallWrites(
+    OS_FileSystem_Config_t* cfg);
+void bench_DiskTrace_captureReplay(
+    OS_FileSystem_Config_t* cfg);
+void bench_WriteAmp_workloads(
+    OS_FileSystem_Config_t* cfg);
+void bench_LittleFsGeometry_sweep(
+    OS_FileSystem_Config_t* cfg);
+void bench_Partitions_interleaved(void);
+bool bench_DiskImage_preloaded(
+    OS_FileSystem_Config_t* cfg);
+void bench_Aging_run(
+    OS_FileSystem_Config_t* cfg);
+void bench_Metadata_scaling(
+    OS_FileSystem_Config_t* cfg);
+void bench_RandomIo_patterns(
+    OS_FileSystem_Config_t* cfg);
+void bench_PowerLoss_recovery(
+    OS_FileSystem_Config_t* cfg);
 
 //------------------------------------------------------------------------------
-static const OS_FileSystem_Format_t littleFsFormat =
-{
-    .littleFs = {
-        .readSize = 4096,
-        .writeSize = 4096,
-        .blockSize = 4096,
-        .blockCycles = 500,
-    }
-};
-
 static OS_FileSystem_Config_t littleCfg =
 {
     .type = OS_FileSystem_Type_LITTLEFS,
     .size = OS_FileSystem_USE_STORAGE_MAX,
-    .format = &littleFsFormat,
+    .format = &bench_littleFsFormat,
     .storage = IF_OS_STORAGE_ASSIGN(
         storage_rpc,
         storage_port),
@@ -67,13 +82,6 @@ static OS_FileSystem_Config_t spiffsCfg =
 };
 
 
-//------------------------------------------------------------------------------
-static if_OS_Storage_t storage =
-    IF_OS_STORAGE_ASSIGN(
-        storage_rpc,
-        storage_port);
-
-
 // Private Functions -----------------------------------------------------------
 
 
@@ -84,7 +92,10 @@ test_OS_FileSystem_mount(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
+
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     if (expectRemoval)
     {
@@ -95,6 +106,7 @@ test_OS_FileSystem_mount(
         TEST_SUCCESS(OS_FileSystem_mount(hFs));
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -106,7 +118,10 @@ test_OS_FileSystem_unmount(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
+
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     if (expectRemoval)
     {
@@ -119,6 +134,7 @@ test_OS_FileSystem_unmount(
         TEST_SUCCESS(OS_FileSystem_unmount(hFs));
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -130,7 +146,10 @@ test_OS_FileSystem_format(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
+
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     if (expectRemoval)
     {
@@ -143,6 +162,7 @@ test_OS_FileSystem_format(
         TEST_SUCCESS(OS_FileSystem_format(hFs));
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -153,7 +173,10 @@ test_OS_FileSystem_maxHandles(
     OS_FileSystem_Handle_t hFs,
     OS_FileSystem_Type_t type)
 {
+    uint64_t start;
+
     TEST_START("i", type);
+    start = bench_getTimeNs();
 
     const uint8_t cMaxFileHandles = 64; // max 255
 
@@ -202,6 +225,7 @@ test_OS_FileSystem_maxHandles(
         );
     }
 
+    bench_logStep(__func__, type, false, start);
     TEST_FINISH();
 }
 
@@ -212,9 +236,16 @@ test_OS_FileSystem(
     OS_FileSystem_Handle_t hFs,
     OS_FileSystem_Type_t type)
 {
+    DISK_STATS_RESET;
+    DISK_DIRTY_RESET;
     test_OS_FileSystem_format(hFs, type, false);
+    bench_logDiskStats("format", type);
+    bench_logDirty("format", type);
     test_OS_FileSystem_mount(hFs, type, false);
+    bench_logDiskStats("mount", type);
+    bench_logDirty("mount", type);
     test_OS_FileSystem_maxHandles(hFs, type);
+    bench_logDiskStats("maxHandles", type);
 
     test_OS_FileSystemFile(hFs, type);
 
@@ -305,126 +336,225 @@ test_OS_FileSystem_fat(void)
     return test_OS_FileSystem_cfg(&fatCfg);
 }
 
-//------------------------------------------------------------------------------
-static OS_Error_t
-hashStorage(
-    OS_Crypto_Handle_t hCrypto,
-    uint8_t*           hash,
-    size_t             len)
-{
-    OS_Error_t err;
-    OS_CryptoDigest_Handle_t hDigest;
-    size_t rd, sz = len;
-    off_t bsz, left, hashed;
-
-    /*
-     * Here we read the entire storage area and compute the SHA256 hash.
-     */
-
-    if ((err = OS_CryptoDigest_init(
-                   &hDigest,
-                   hCrypto,
-                   OS_CryptoDigest_ALG_SHA256)) != OS_SUCCESS)
-    {
-        return err;
-    }
-
-    if ((err = storage.getSize(&left)) != OS_SUCCESS)
-    {
-        goto out;
-    }
-
-    hashed  = 0;
-    bsz     = OS_Dataport_getSize(storage.dataport);
-
-    while (left > 0)
-    {
-        if ((err = storage.read(hashed, bsz, &rd)) != OS_SUCCESS)
-        {
-            goto out;
-        }
-        if ((err = OS_CryptoDigest_process(
-                       hDigest,
-                       OS_Dataport_getBuf(storage.dataport),
-                       rd)) != OS_SUCCESS)
-        {
-            goto out;
-        }
-
-        hashed  += rd;
-        left    -= rd;
-        bsz      = (left < bsz) ? left : bsz;
-    }
-
-    err = OS_CryptoDigest_finalize(hDigest, hash, &sz);
-
-out:
-    OS_CryptoDigest_free(hDigest);
-    return err;
-}
-
 //------------------------------------------------------------------------------
 /**
- * This macro mounts a fs with one fs format, then computes a hash on it. Then it
- * tries mounting with a different fs format, and again computes a hash. We expect
- * that mounting fails, but the hash remains the same (i.e., mounting does not
- * touch the storage) ...
+ * This macro mounts a fs with one fs format, then gets the write generation of
+ * the disk. Then it tries mounting with a different fs format, and again gets
+ * the generation. We expect that mounting fails, but the generation remains
+ * the same (i.e., mounting does not touch the storage) ...
  */
-#define FORMAT_AND_MOUNT(_fs_, _fmt_, _mnt_, _cr_, _h0_, _h1_) \
+#define FORMAT_AND_MOUNT(_fs_, _fmt_, _mnt_, _g0_, _g1_) \
     { \
         TEST_SUCCESS(OS_FileSystem_init(&_fs_, &_fmt_)); \
         TEST_SUCCESS(OS_FileSystem_format(_fs_)); \
         TEST_SUCCESS(OS_FileSystem_free(_fs_)); \
-        TEST_SUCCESS(hashStorage(_cr_, _h0_, sizeof(_h0_))); \
+        TEST_SUCCESS(CACHE_FLUSH); \
+        TEST_SUCCESS(disk_rpc_getGeneration(&_g0_)); \
         TEST_SUCCESS(OS_FileSystem_init(&_fs_, &_mnt_));\
         TEST_NOT_FOUND(OS_FileSystem_mount(_fs_)); \
         TEST_SUCCESS(OS_FileSystem_free(_fs_)); \
-        TEST_SUCCESS(hashStorage(_cr_, _h1_, sizeof(_h1_))); \
-        TEST_TRUE(!memcmp(_h1_, _h0_, sizeof(_h0_))); \
+        TEST_SUCCESS(CACHE_FLUSH); \
+        TEST_SUCCESS(disk_rpc_getGeneration(&_g1_)); \
+        TEST_TRUE(_g1_ == _g0_); \
     }
 
 //------------------------------------------------------------------------------
 static OS_Error_t
 test_OS_FileSystem_mount_fail(void)
 {
-    static OS_Crypto_Config_t cfgCrypto =
-    {
-        .mode = OS_Crypto_MODE_LIBRARY,
-        .entropy = IF_OS_ENTROPY_ASSIGN(
-            entropy_rpc,
-            entropy_port),
-    };
     OS_FileSystem_Handle_t hFs;
-    OS_Crypto_Handle_t hCrypto;
-    uint8_t hash0[32], hash1[32];
+    uint64_t gen0, gen1;
 
     TEST_START();
 
-    TEST_SUCCESS(OS_Crypto_init(&hCrypto, &cfgCrypto));
-
     // Format with FAT, mount with others
-    FORMAT_AND_MOUNT(hFs, fatCfg, littleCfg, hCrypto, hash0, hash1);
-    FORMAT_AND_MOUNT(hFs, fatCfg, spiffsCfg, hCrypto, hash0, hash1);
+    FORMAT_AND_MOUNT(hFs, fatCfg, littleCfg, gen0, gen1);
+    FORMAT_AND_MOUNT(hFs, fatCfg, spiffsCfg, gen0, gen1);
 
     // Format with LittleFS, mount with others
-    FORMAT_AND_MOUNT(hFs, littleCfg, fatCfg, hCrypto, hash0, hash1);
-    FORMAT_AND_MOUNT(hFs, littleCfg, spiffsCfg, hCrypto, hash0, hash1);
+    FORMAT_AND_MOUNT(hFs, littleCfg, fatCfg, gen0, gen1);
+    FORMAT_AND_MOUNT(hFs, littleCfg, spiffsCfg, gen0, gen1);
 
     // Format with SPIFFS, mount with others
-    FORMAT_AND_MOUNT(hFs, spiffsCfg, fatCfg, hCrypto, hash0, hash1);
-    FORMAT_AND_MOUNT(hFs, spiffsCfg, littleCfg, hCrypto, hash0, hash1);
-
-    TEST_SUCCESS(OS_Crypto_free(hCrypto));
+    FORMAT_AND_MOUNT(hFs, spiffsCfg, fatCfg, gen0, gen1);
+    FORMAT_AND_MOUNT(hFs, spiffsCfg, littleCfg, gen0, gen1);
 
     TEST_FINISH();
 
     return OS_SUCCESS;
 }
 
+//------------------------------------------------------------------------------
+// Benchmarks
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_DiskImage_preloaded_any(void)
+{
+    // Mounting does not write, so trying the wrong types first does no harm
+    if (!bench_DiskImage_preloaded(&littleCfg)
+        && !bench_DiskImage_preloaded(&spiffsCfg)
+        && !bench_DiskImage_preloaded(&fatCfg))
+    {
+        Debug_LOG_INFO("No volume preloaded on the disk");
+    }
+
+    return OS_SUCCESS;
+}
+
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_OS_FileSystem_throughput_all(void)
+{
+    bench_OS_FileSystem_throughput(&littleCfg);
+    bench_OS_FileSystem_throughput(&spiffsCfg);
+    bench_OS_FileSystem_throughput(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_RemovableDisk_vectored_io(void)
+{
+    bench_RemovableDisk_vectored();
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_RemovableDisk_async_io(void)
+{
+    bench_RemovableDisk_queueDepth();
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_BlockCache_small_writes(void)
+{
+    bench_BlockCache_smallWrites(&littleCfg);
+    bench_BlockCache_smallWrites(&spiffsCfg);
+    bench_BlockCache_smallWrites(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_DiskTrace_capture_replay(void)
+{
+    bench_DiskTrace_captureReplay(&littleCfg);
+    bench_DiskTrace_captureReplay(&spiffsCfg);
+    bench_DiskTrace_captureReplay(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_WriteAmp_all(void)
+{
+    bench_WriteAmp_workloads(&littleCfg);
+    bench_WriteAmp_workloads(&spiffsCfg);
+    bench_WriteAmp_workloads(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_LittleFsGeometry_all(void)
+{
+    bench_LittleFsGeometry_sweep(&littleCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_Partitions_two_fs(void)
+{
+    bench_Partitions_interleaved();
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_Aging_all(void)
+{
+    bench_Aging_run(&littleCfg);
+    bench_Aging_run(&spiffsCfg);
+    bench_Aging_run(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+#if defined(bench_AGED_IMAGE_FS)
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_Aging_image(void)
+{
+    OS_FileSystem_Config_t* const cfgs[] = { &littleCfg, &spiffsCfg, &fatCfg };
+
+    for (size_t i = 0; i < sizeof(cfgs) / sizeof(cfgs[0]); i++)
+    {
+        if (cfgs[i]->type == bench_AGED_IMAGE_FS)
+        {
+            bench_Aging_run(cfgs[i]);
+            return OS_SUCCESS;
+        }
+    }
+
+    return OS_ERROR_INVALID_PARAMETER;
+}
+#endif
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_Metadata_all(void)
+{
+    bench_Metadata_scaling(&littleCfg);
+    bench_Metadata_scaling(&spiffsCfg);
+    bench_Metadata_scaling(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_RandomIo_all(void)
+{
+    bench_RandomIo_patterns(&littleCfg);
+    bench_RandomIo_patterns(&spiffsCfg);
+    bench_RandomIo_patterns(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+static OS_Error_t
+bench_PowerLoss_all(void)
+{
+    bench_PowerLoss_recovery(&littleCfg);
+    bench_PowerLoss_recovery(&spiffsCfg);
+    bench_PowerLoss_recovery(&fatCfg);
+
+    return OS_SUCCESS;
+}
+
 //------------------------------------------------------------------------------
 #define DO_RUN_TEST_SCENARIO(_test_scenario_func_) \
     { \
+        uint64_t start = bench_getTimeNs(); \
         OS_Error_t ret = _test_scenario_func_(); \
+        bench_logScenario( #_test_scenario_func_, start, ret); \
         if (ret != OS_SUCCESS) \
         { \
             Debug_LOG_ERROR( #_test_scenario_func_ "() FAILED, code %d", ret); \
@@ -441,12 +571,34 @@ test_OS_FileSystem_mount_fail(void)
 //------------------------------------------------------------------------------
 int run()
 {
+#if defined(bench_AGED_IMAGE_FS)
+    // Leave only an aged volume on the disk, to be kept as disk image
+    DO_RUN_TEST_SCENARIO( bench_Aging_image );
+    return 0;
+#endif
+
+    // Must come first, all others format the disk
+    DO_RUN_TEST_SCENARIO( bench_DiskImage_preloaded_any );
+
     DO_RUN_TEST_SCENARIO( test_OS_FileSystem_little_fs );
     DO_RUN_TEST_SCENARIO( test_OS_FileSystem_spiffs );
     DO_RUN_TEST_SCENARIO( test_OS_FileSystem_fat );
 
     DO_RUN_TEST_SCENARIO( test_OS_FileSystem_mount_fail );
 
+    DO_RUN_TEST_SCENARIO( bench_OS_FileSystem_throughput_all );
+    DO_RUN_TEST_SCENARIO( bench_RemovableDisk_vectored_io );
+    DO_RUN_TEST_SCENARIO( bench_RemovableDisk_async_io );
+    DO_RUN_TEST_SCENARIO( bench_BlockCache_small_writes );
+    DO_RUN_TEST_SCENARIO( bench_DiskTrace_capture_replay );
+    DO_RUN_TEST_SCENARIO( bench_WriteAmp_all );
+    DO_RUN_TEST_SCENARIO( bench_LittleFsGeometry_all );
+    DO_RUN_TEST_SCENARIO( bench_Partitions_two_fs );
+    DO_RUN_TEST_SCENARIO( bench_Aging_all );
+    DO_RUN_TEST_SCENARIO( bench_Metadata_all );
+    DO_RUN_TEST_SCENARIO( bench_RandomIo_all );
+    DO_RUN_TEST_SCENARIO( bench_PowerLoss_all );
+
     Debug_LOG_INFO("All test scenarios completed");
 
     return 0;
@@ -10,6 +10,8 @@
 
 #include "lib_macros/Test.h"
 #include "RemovableDisk.h"
+#include "bench.h"
+#include "bench_stats.h"
 
 #include <string.h>
 
@@ -29,7 +31,10 @@ test_OS_FileSystemFile_open(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
+
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     if (expectRemoval)
     {
@@ -47,6 +52,7 @@ test_OS_FileSystemFile_open(
                                             OS_FileSystem_OpenFlags_CREATE));
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -56,9 +62,11 @@ test_OS_FileSystemFile_close(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
     OS_Error_t err;
 
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     err = OS_FileSystemFile_close(hFs, hFile);
     if (expectRemoval)
@@ -73,6 +81,7 @@ test_OS_FileSystemFile_close(
         TEST_SUCCESS(err);
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -82,11 +91,13 @@ test_OS_FileSystemFile_read(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
     uint8_t buf[sizeof(fileData)];
     off_t to_read, read;
     OS_Error_t err;
 
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     to_read = fileSize;
     read    = 0;
@@ -110,6 +121,7 @@ test_OS_FileSystemFile_read(
         to_read -= sizeof(buf);
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -119,10 +131,12 @@ test_OS_FileSystemFile_write(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
     off_t to_write, written;
     OS_Error_t err;
 
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     to_write = fileSize;
     written  = 0;
@@ -150,6 +164,7 @@ test_OS_FileSystemFile_write(
         to_write -= sizeof(fileData);
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -159,7 +174,10 @@ test_OS_FileSystemFile_delete(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
+
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     if (expectRemoval)
     {
@@ -172,6 +190,7 @@ test_OS_FileSystemFile_delete(
         TEST_SUCCESS(OS_FileSystemFile_delete(hFs, fileName));
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -181,9 +200,11 @@ test_OS_FileSystemFile_getSize(
     OS_FileSystem_Type_t type,
     bool expectRemoval)
 {
+    uint64_t start;
     off_t size;
 
     TEST_START("i", expectRemoval, "i", type);
+    start = bench_getTimeNs();
 
     if (expectRemoval)
     {
@@ -197,6 +218,7 @@ test_OS_FileSystemFile_getSize(
         TEST_TRUE(size == fileSize);
     }
 
+    bench_logStep(__func__, type, expectRemoval, start);
     TEST_FINISH();
 }
 
@@ -207,10 +229,16 @@ test_OS_FileSystemFile(
     OS_FileSystem_Handle_t hFs,
     OS_FileSystem_Type_t type)
 {
+    bench_startWriteAmp();
     test_OS_FileSystemFile_open(hFs, type, false);
+    bench_logDiskStats("file open", type);
     test_OS_FileSystemFile_write(hFs, type, false);
+    bench_logDiskStats("file write", type);
     test_OS_FileSystemFile_read(hFs, type, false);
+    bench_logDiskStats("file read", type);
     test_OS_FileSystemFile_close(hFs, type, false);
+    bench_logDiskStats("file close", type);
+    bench_logWriteAmp("file", type, fileSize);
 
     test_OS_FileSystemFile_getSize(hFs, type, false);
     test_OS_FileSystemFile_delete(hFs, type, false);
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+/*
+ * Stand-in for the TimeServer client API in the host build; time comes from
+ * the monotonic clock of the host, sleeping is done by the host as well.
+ */
+
+#include "OS_Error.h"
+
+#include <stdint.h>
+
+typedef struct
+{
+    int unused;
+} if_OS_Timer_t;
+
+#define IF_OS_TIMER_ASSIGN(_rpc_, _notify_) { .unused = 0 }
+
+typedef enum
+{
+    TimeServer_PRECISION_SEC,
+    TimeServer_PRECISION_MSEC,
+    TimeServer_PRECISION_USEC,
+    TimeServer_PRECISION_NSEC,
+} TimeServer_Precision_t;
+
+OS_Error_t
+TimeServer_getTime(
+    const if_OS_Timer_t*   timer,
+    TimeServer_Precision_t precision,
+    uint64_t*              time);
+
+OS_Error_t
+TimeServer_sleep(
+    const if_OS_Timer_t*   timer,
+    TimeServer_Precision_t precision,
+    uint64_t               time);
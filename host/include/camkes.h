@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+/*
+ * Stand-in for the header CAmkES generates for a component, for the host
+ * build. All components run in one process there; an interface a component
+ * uses is the same symbol as the interface of the component it is connected
+ * to. Where the names on both sides differ, the host build renames them when
+ * compiling the component, see host/CMakeLists.txt. The attributes are set
+ * there as well.
+ */
+
+#include "OS_Error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define CAMKES_CONST_ATTR(_attr_)   HOST_ATTR_ ## _attr_
+
+const char*
+get_instance_name(
+    void);
+
+int
+run(
+    void);
+
+// Procedures ------------------------------------------------------------------
+
+#define HOST_DECLARE_STORAGE_RPC(_rpc_)                                     \
+    OS_Error_t _rpc_ ## _write(off_t offset, size_t size, size_t* written); \
+    OS_Error_t _rpc_ ## _read(off_t offset, size_t size, size_t* read);     \
+    OS_Error_t _rpc_ ## _erase(off_t offset, off_t size, off_t* erased);    \
+    OS_Error_t _rpc_ ## _getSize(off_t* size);                              \
+    OS_Error_t _rpc_ ## _getBlockSize(size_t* blockSize);                   \
+    OS_Error_t _rpc_ ## _getState(uint32_t* flags);
+
+HOST_DECLARE_STORAGE_RPC(storage_rpc)
+HOST_DECLARE_STORAGE_RPC(lower_rpc)
+HOST_DECLARE_STORAGE_RPC(part0_rpc)
+HOST_DECLARE_STORAGE_RPC(part1_rpc)
+HOST_DECLARE_STORAGE_RPC(part2_rpc)
+HOST_DECLARE_STORAGE_RPC(part3_rpc)
+
+// if_RemovableDisk
+OS_Error_t disk_rpc_triggerRemoval(int ops);
+OS_Error_t disk_rpc_powerCut(int mods, int cut);
+OS_Error_t disk_rpc_getStats(size_t* size);
+OS_Error_t disk_rpc_resetStats(void);
+OS_Error_t disk_rpc_writev(size_t count, size_t* written);
+OS_Error_t disk_rpc_readv(size_t count, size_t* read);
+OS_Error_t disk_rpc_setTrace(int enable);
+OS_Error_t disk_rpc_getTrace(size_t first, size_t* count, size_t* total,
+                             size_t* dropped);
+OS_Error_t disk_rpc_replayTrace(size_t count, uint64_t* ns);
+OS_Error_t disk_rpc_digest(off_t offset, off_t size, uint64_t* digest);
+OS_Error_t disk_rpc_getGeneration(uint64_t* generation);
+OS_Error_t disk_rpc_getDirty(size_t* size);
+OS_Error_t disk_rpc_resetDirty(void);
+OS_Error_t disk_rpc_snapshot(void);
+OS_Error_t disk_rpc_restore(size_t* blocks);
+
+// if_BlockCache
+OS_Error_t cache_rpc_setMode(int mode);
+OS_Error_t cache_rpc_flush(void);
+OS_Error_t cache_rpc_getStats(size_t* size);
+OS_Error_t cache_rpc_resetStats(void);
+
+// Dataports -------------------------------------------------------------------
+
+extern void* storage_port;
+extern void* lower_port;
+extern void* disk_port;
+extern void* part0_port;
+extern void* part1_port;
+extern void* part2_port;
+extern void* part3_port;
+extern void* async_port;
+extern void* async_data_port;
+
+// Events ----------------------------------------------------------------------
+
+void async_submit_emit(void);
+int async_submit_reg_callback(void (*callback)(void*), void* arg);
+void async_complete_emit(void);
+void async_complete_wait(void);
+int async_complete_poll(void);
+
+// Mutexes ---------------------------------------------------------------------
+
+int io_lock_lock(void);
+int io_lock_unlock(void);
+int cache_lock_lock(void);
+int cache_lock_unlock(void);
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Set the path of the image file to map, before the disk is initialized.
+ */
+void
+HostImage_setPath(
+    const char* path);
+
+/**
+ * Map the image file into memory, creating or resizing it to size bytes; new
+ * bytes are set to fill. The content of an existing file is kept, so it can be
+ * looked at (or mounted) after a run. Does not return on failure.
+ */
+uint8_t*
+HostImage_map(
+    size_t  size,
+    uint8_t fill);
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "host_image.h"
+
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+ * What CAmkES provides at runtime, for all components of the host build
+ * together: the memory of the dataports, the events and the mutexes. All
+ * components run in the thread of main(), so calls between them are plain
+ * function calls and the mutexes have nothing to do.
+ */
+
+void RemovableDisk_post_init(void);
+void BlockCache_post_init(void);
+
+// Dataports, sized like in main.camkes
+#define DATAPORT(_name_, _size_)                                        \
+    static uint8_t _name_ ## _mem[_size_] __attribute__((aligned(4096))); \
+    void* _name_ = _name_ ## _mem;
+
+DATAPORT(storage_port,      4096)
+DATAPORT(lower_port,        4096)
+DATAPORT(disk_port,         4096)
+DATAPORT(part0_port,        4096)
+DATAPORT(part1_port,        4096)
+DATAPORT(async_port,        4096)
+DATAPORT(async_data_port,   32768)
+
+// Partitions 2 and 3 are not connected
+void* part2_port = NULL;
+void* part3_port = NULL;
+
+// The disk serves a submission right away, when the client signals it
+static void (*submitCallback)(void*);
+static void* submitArg;
+static bool submitPending;
+static bool completePending;
+
+// Public Functions ------------------------------------------------------------
+
+const char*
+get_instance_name(
+    void)
+{
+    return "host";
+}
+
+void
+async_submit_emit(
+    void)
+{
+    void (*const callback)(void*) = submitCallback;
+
+    if (NULL == callback)
+    {
+        submitPending = true;
+        return;
+    }
+
+    // Callbacks are called once, the disk registers again when done
+    submitCallback = NULL;
+    callback(submitArg);
+}
+
+int
+async_submit_reg_callback(
+    void (*callback)(void*),
+    void* arg)
+{
+    submitCallback = callback;
+    submitArg      = arg;
+
+    if (submitPending)
+    {
+        submitPending = false;
+        async_submit_emit();
+    }
+
+    return 0;
+}
+
+void
+async_complete_emit(
+    void)
+{
+    completePending = true;
+}
+
+void
+async_complete_wait(
+    void)
+{
+    // Everything submitted is done already, so nothing can come any more
+    if (!completePending)
+    {
+        Debug_LOG_ERROR("Waiting for a completion which never comes");
+        abort();
+    }
+
+    completePending = false;
+}
+
+int
+async_complete_poll(
+    void)
+{
+    bool const pending = completePending;
+
+    completePending = false;
+
+    return pending;
+}
+
+int
+io_lock_lock(
+    void)
+{
+    return 0;
+}
+
+int
+io_lock_unlock(
+    void)
+{
+    return 0;
+}
+
+int
+cache_lock_lock(
+    void)
+{
+    return 0;
+}
+
+int
+cache_lock_unlock(
+    void)
+{
+    return 0;
+}
+
+/*
+ * Usage: test_filesystem_host [image]
+ *
+ * The disk is backed by the image file, "disk.img" if none is given.
+ */
+int
+main(
+    int   argc,
+    char* argv[])
+{
+    if (argc > 1)
+    {
+        HostImage_setPath(argv[1]);
+    }
+
+    RemovableDisk_post_init();
+    BlockCache_post_init();
+
+    return run();
+}
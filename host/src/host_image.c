@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "host_image.h"
+
+#include "lib_debug/Debug.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char* imagePath = "disk.img";
+
+// Public Functions ------------------------------------------------------------
+
+void
+HostImage_setPath(
+    const char* path)
+{
+    imagePath = path;
+}
+
+uint8_t*
+HostImage_map(
+    size_t  size,
+    uint8_t fill)
+{
+    struct stat st;
+    uint8_t* mem;
+    int fd;
+
+    if ((fd = open(imagePath, O_RDWR | O_CREAT, 0644)) < 0)
+    {
+        Debug_LOG_ERROR("Opening image '%s' failed: %s", imagePath,
+                        strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    if ((fstat(fd, &st) != 0)
+        || ((st.st_size != (off_t)size) && (ftruncate(fd, size) != 0)))
+    {
+        Debug_LOG_ERROR("Resizing image '%s' failed: %s", imagePath,
+                        strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == mem)
+    {
+        Debug_LOG_ERROR("Mapping image '%s' failed: %s", imagePath,
+                        strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // Growing the file added zeros
+    if ((st.st_size < (off_t)size) && (fill != 0))
+    {
+        memset(&mem[st.st_size], fill, size - st.st_size);
+    }
+
+    Debug_LOG_INFO("Image '%s': %zu bytes mapped", imagePath, size);
+
+    return mem;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "TimeServer.h"
+
+#include <time.h>
+
+static const uint64_t nsPerUnit[] =
+{
+    [TimeServer_PRECISION_SEC]  = 1000000000ULL,
+    [TimeServer_PRECISION_MSEC] = 1000000ULL,
+    [TimeServer_PRECISION_USEC] = 1000ULL,
+    [TimeServer_PRECISION_NSEC] = 1ULL,
+};
+
+// Public Functions ------------------------------------------------------------
+
+OS_Error_t
+TimeServer_getTime(
+    const if_OS_Timer_t*   timer,
+    TimeServer_Precision_t precision,
+    uint64_t*              time)
+{
+    struct timespec ts;
+
+    if ((NULL == timer) || (NULL == time)
+        || (precision > TimeServer_PRECISION_NSEC))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+    {
+        return OS_ERROR_GENERIC;
+    }
+
+    *time = ((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec)
+            / nsPerUnit[precision];
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+TimeServer_sleep(
+    const if_OS_Timer_t*   timer,
+    TimeServer_Precision_t precision,
+    uint64_t               time)
+{
+    uint64_t ns;
+    struct timespec ts;
+
+    if ((NULL == timer) || (precision > TimeServer_PRECISION_NSEC))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    ns = time * nsPerUnit[precision];
+    ts.tv_sec  = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+
+    while (nanosleep(&ts, &ts) != 0)
+    {
+        // Interrupted, sleep for the rest
+    }
+
+    return OS_SUCCESS;
+}